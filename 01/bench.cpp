@@ -0,0 +1,685 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+#include "bigint.h"
+#include "bigint_accumulator.h"
+#include "bigint_divisor.h"
+#include "bigint_modulus.h"
+#include "bigint_serialize.h"
+#include "bigint_tree.h"
+#include "binary_bigint.h"
+#include "fixed_bigint.h"
+#include "calculator.h"
+
+// Замеры производительности длинной арифметики.
+// Запуск: ./bench [раздел], без аргументов — все разделы подряд.
+
+static BigInt random_bigint(int n, mt19937 &gen) {
+    BigInt x;
+    x.a.resize(n);
+    for (int i = 0; i < n; ++i) x.a[i] = gen() % BASE;
+    if (n) x.a.back() = 1 + gen() % (BASE - 1);
+    return x;
+}
+
+// Счетчик обращений к куче: глобальный operator new перекрыт целиком.
+static size_t g_allocations = 0, g_allocated_bytes = 0;
+
+void *operator new(size_t size) {
+    ++g_allocations;
+    g_allocated_bytes += size;
+    if (void *p = malloc(size)) return p;
+    throw bad_alloc();
+}
+void operator delete(void *p) noexcept {
+    free(p);
+}
+// Удаление с размером (C++14) идет туда же, иначе оно ушло бы мимо malloc.
+void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+// Среднее время одного вызова f в миллисекундах, крутим не меньше 0.2 с.
+template <typename F> static double time_ms(F f) {
+    auto start = chrono::steady_clock::now();
+    int iterations = 0;
+    double elapsed;
+    do {
+        f();
+        ++iterations;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start)
+                      .count();
+    } while (elapsed < 0.2);
+    return elapsed * 1000 / iterations;
+}
+
+// Деление 2m лимбов на m: старое школьное против Algorithm D и того, что
+// в итоге выбирает divmod.
+static void bench_div() {
+    mt19937 gen(1);
+    printf("%8s %12s %12s %8s %12s\n", "limbs", "simple, ms", "knuth, ms",
+           "speedup", "divmod, ms");
+    for (int m : {2, 8, 32, 128, 512, 2048, 4096}) {
+        BigInt x = random_bigint(2 * m, gen), y = random_bigint(m, gen);
+        double simple = time_ms([&] { BigInt::divmod_simple(x, y); });
+        double knuth = time_ms([&] { BigInt::divmod_knuth(x, y); });
+        double best = time_ms([&] { divmod(x, y); });
+        printf("%8d %12.4f %12.4f %8.1f %12.4f\n", m, simple, knuth,
+               simple / knuth, best);
+    }
+}
+
+// Один делитель на много делимых: divmod каждый раз против BigIntDivisor.
+static void bench_divisor() {
+    mt19937 gen(9);
+    printf("%8s %8s %12s %12s %8s\n", "dividend", "divisor", "divmod, us",
+           "divisor, us", "speedup");
+    for (int m : {1, 4, 32, 1100}) {
+        for (int n : {2 * m, m + 3000}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            BigIntDivisor d(y);
+            double plain = time_ms([&] { divmod(x, y); });
+            double fast = time_ms([&] { d.divmod(x); });
+            printf("%8d %8d %12.2f %12.2f %8.2f\n", n, m, plain * 1000,
+                   fast * 1000, plain / fast);
+        }
+    }
+}
+
+// НОД двух случайных чисел одной длины: Евклид на '%' против gcd.
+static void bench_gcd() {
+    mt19937 gen(10);
+    printf("%8s %12s %12s %8s\n", "limbs", "euclid, ms", "gcd, ms", "speedup");
+    for (int n : {2, 8, 32, 128, 512, 2048, 8192}) {
+        BigInt x = random_bigint(n, gen), y = random_bigint(n, gen);
+        double fast = time_ms([&] { gcd(x, y); });
+        if (n > 2048) { // Евклида здесь уже не дождаться
+            printf("%8d %12s %12.4f\n", n, "-", fast);
+            continue;
+        }
+        double euclid = time_ms([&] { BigInt::gcd_euclid(x, y); });
+        printf("%8d %12.4f %12.4f %8.1f\n", n, euclid, fast, euclid / fast);
+    }
+}
+
+// Квадратный корень: по цифре против Ньютона с удвоением точности;
+// рядом время умножения того же размера для масштаба.
+static void bench_sqrt() {
+    mt19937 gen(11);
+    printf("%8s %12s %12s %12s %12s\n", "limbs", "simple, ms", "newton, ms",
+           "cbrt, ms", "mul, ms");
+    for (int n : {8, 64, 512, 4096, 32768}) {
+        BigInt x = random_bigint(n, gen), h = random_bigint(n / 2, gen);
+        double newton = time_ms([&] { sqrt_rem(x); });
+        double cube = time_ms([&] { nth_root_rem(x, 3); });
+        double mul = time_ms([&] { h * h; });
+        if (n > 512) { // по цифре здесь уже не дождаться
+            printf("%8d %12s %12.4f %12.4f %12.4f\n", n, "-", newton, cube, mul);
+            continue;
+        }
+        double simple = time_ms([&] { BigInt::sqrt_simple(x); });
+        printf("%8d %12.4f %12.4f %12.4f %12.4f\n", n, simple, newton, cube, mul);
+    }
+}
+
+// Произведение n коротких чисел: слева направо против дерева, тот же
+// выбор для факториала и для цепочки '*' в калькуляторе.
+static void bench_tree() {
+    mt19937 gen(12);
+    printf("%8s %12s %12s %12s %12s %12s\n", "n", "fold, ms", "tree, ms",
+           "n!, fold", "n!, tree", "calc, ms");
+    for (int n : {100, 1000, 10000, 50000}) {
+        vector<BigInt> xs;
+        string expression = "1";
+        for (int i = 0; i < n; ++i) {
+            xs.push_back(random_bigint(1, gen));
+            ostringstream out;
+            out << " * " << xs.back();
+            expression += out.str();
+        }
+        double fold = time_ms([&] {
+            BigInt res = 1;
+            for (const BigInt &x : xs) res *= x;
+        });
+        double tree = time_ms([&] { product(xs.begin(), xs.end()); });
+        double fact_fold = time_ms([&] {
+            BigInt res = 1;
+            for (int i = 2; i <= n; ++i) res *= i;
+        });
+        double fact_tree = time_ms([&] { factorial(n); });
+        CCalculator calc;
+        double chain = time_ms([&] { calc.process(expression.c_str()); });
+        printf("%8d %12.3f %12.3f %12.3f %12.3f %12.3f\n", n, fold, tree,
+               fact_fold, fact_tree, chain);
+    }
+}
+
+// Карацуба на сбалансированных множителях: время и походы в кучу за вызов.
+static void bench_karatsuba() {
+    mt19937 gen(3);
+    printf("%8s %12s %12s\n", "limbs", "time, ms", "allocations");
+    for (int n : {64, 256, 1024, 4096}) {
+        BigInt x = random_bigint(n, gen), y = random_bigint(n, gen);
+        size_t before = g_allocations;
+        x.mul_karatsuba(y);
+        size_t allocations = g_allocations - before;
+        double ms = time_ms([&] { x.mul_karatsuba(y); });
+        printf("%8d %12.4f %12zu\n", n, ms, allocations);
+    }
+}
+
+// Длинное на короткое: куски по длине короткого против того, что было
+// раньше — школьного ниже порога Toom-3 и NTT целиком выше порога NTT.
+static void bench_unbalanced() {
+    mt19937 gen(13);
+    printf("%8s %8s %12s %12s %12s\n", "long", "short", "chunks, ms",
+           "simple, ms", "ntt, ms");
+    for (int m : {300, 1000, 4000}) {
+        for (int n : {20000, 200000}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            double chunks = time_ms([&] { x.mul_unbalanced(y); });
+            double ntt = time_ms([&] { x.mul_ntt(y); });
+            if (n > 20000) { // школьное здесь слишком долго
+                printf("%8d %8d %12.3f %12s %12.3f\n", n, m, chunks, "-", ntt);
+                continue;
+            }
+            double simple = time_ms([&] { x.mul_simple(y); });
+            printf("%8d %8d %12.3f %12.3f %12.3f\n", n, m, chunks, simple, ntt);
+        }
+    }
+}
+
+// x * x через ядра возведения в квадрат против умножения на копию.
+static void bench_square() {
+    mt19937 gen(4);
+    printf("%8s %12s %12s %8s\n", "limbs", "x * y, ms", "x * x, ms",
+           "speedup");
+    for (int n : {16, 128, 512, 4096, 32768}) {
+        BigInt x = random_bigint(n, gen), y = x;
+        double mul = time_ms([&] { x * y; });
+        double sqr = time_ms([&] { x * x; });
+        printf("%8d %12.4f %12.4f %8.2f\n", n, mul, sqr, mul / sqr);
+    }
+}
+
+// Масштабирование длинного умножения по потокам: от одного до числа ядер.
+static void bench_threads() {
+    mt19937 gen(5);
+    int cores = max(1u, thread::hardware_concurrency());
+    BigInt kx = random_bigint(1 << 15, gen), ky = random_bigint(1 << 15, gen);
+    BigInt nx = random_bigint(1 << 20, gen), ny = random_bigint(1 << 20, gen);
+    printf("%8s %16s %8s %16s %8s\n", "threads", "karatsuba, ms", "speedup",
+           "ntt, ms", "speedup");
+    double karatsuba1 = 0, ntt1 = 0;
+    for (int threads = 1;; threads = min(2 * threads, cores)) {
+        BigInt::mul_threads() = threads;
+        double karatsuba = time_ms([&] { kx.mul_karatsuba(ky); });
+        double ntt = time_ms([&] { nx.mul_ntt(ny); });
+        if (threads == 1) karatsuba1 = karatsuba, ntt1 = ntt;
+        printf("%8d %16.2f %8.2f %16.2f %8.2f\n", threads, karatsuba,
+               karatsuba1 / karatsuba, ntt, ntt1 / ntt);
+        if (threads == cores) break;
+    }
+    BigInt::mul_threads() = 1;
+}
+
+// Много одинаковых умножений подряд: здесь заметна подготовка преобразования.
+static void bench_repeat() {
+    mt19937 gen(6);
+    printf("%8s %12s %12s\n", "limbs", "ntt, us", "fft, us");
+    for (int n : {64, 512, 4096}) {
+        BigInt x = random_bigint(n, gen), y = random_bigint(n, gen);
+        double ntt = time_ms([&] { x.mul_ntt(y); });
+        double fft = time_ms([&] { x.mul_fft(y); });
+        printf("%8d %12.2f %12.2f\n", n, ntt * 1000, fft * 1000);
+    }
+}
+
+// Десятичные лимбы против двоичных на одних и тех же числах.
+static void bench_binary() {
+    mt19937 gen(7);
+    printf("%8s %8s %12s %12s\n", "digits", "op", "BigInt, ms", "binary, ms");
+    for (int n : {100, 1000, 10000, 100000}) {
+        BigInt x = random_bigint(n / 9, gen), y = random_bigint(n / 18, gen);
+        ostringstream xs, ys;
+        xs << x;
+        ys << y;
+        BinaryBigInt bx(xs.str()), by(ys.str());
+        string s = xs.str();
+        auto row = [&](const char *op, double decimal, double binary) {
+            printf("%8d %8s %12.4f %12.4f\n", n, op, decimal, binary);
+        };
+        row("+", time_ms([&] { x + y; }), time_ms([&] { bx + by; }));
+        row("*", time_ms([&] { x * y; }), time_ms([&] { bx * by; }));
+        row("/", time_ms([&] { x / y; }), time_ms([&] { bx / by; }));
+        row("read", time_ms([&] { BigInt t(s); }), time_ms([&] { BinaryBigInt t(s); }));
+        ostringstream sink;
+        row("write", time_ms([&] { sink.str(""), sink << x; }),
+            time_ms([&] { sink.str(""), sink << bx; }));
+    }
+}
+
+// Пропускная способность ядер сложения, вычитания и умножения на int,
+// в лимбах за наносекунду.
+static void bench_kernels() {
+    mt19937 gen(8);
+    BigInt::LimbKernels kernels[] = {BigInt::simd_kernels(false),
+                                     BigInt::simd_kernels(true)};
+    // Без AVX2 меряем только скалярные.
+    int count = BigInt::cpu_has_avx2() ? 2 : 1;
+    if (count == 1) printf("no AVX2, scalar kernels only\n");
+    printf("%8s %8s %12s %12s %12s\n", "limbs", "kernel", "add", "sub",
+           "mul_small");
+    for (int n : {64, 1024, 16384, 262144}) {
+        vector<int> a(n), b(n);
+        for (int i = 0; i < n; ++i) a[i] = gen() % BASE, b[i] = gen() % BASE;
+        for (int k = 0; k < count; ++k) {
+            BigInt::LimbKernels &kernel = kernels[k];
+            vector<int> x = a;
+            // Сложение с вычитанием по очереди держат лимбы в диапазоне.
+            double add = time_ms([&] { kernel.add(x.data(), b.data(), n, 0); });
+            double sub = time_ms([&] { kernel.sub(x.data(), b.data(), n, 0); });
+            double mul = time_ms([&] {
+                x = a;
+                kernel.mul_small(x.data(), n, 999999937, 0);
+            });
+            double copy = time_ms([&] { x = a; });
+            printf("%8d %8s %12.2f %12.2f %12.2f\n", n, k ? "simd" : "scalar",
+                   n / (add * 1e6), n / (sub * 1e6), n / ((mul - copy) * 1e6));
+        }
+    }
+}
+
+// Сколько раз калькулятор ходит в кучу на типичных выражениях: с ареной
+// и без нее, а также на прямых операциях с длинными временными числами.
+static void bench_alloc() {
+    string big(100, '7'), other(90, '3');
+    string mixed = big + " * " + other + " / 7 - " + big + " * -3 + " + other +
+                   " / " + big + " - -" + other;
+    const char *expressions[] = {
+        "2 + 3 * 4 - -2",
+        "-515/219*  140",
+        "7+6+7+8-5",
+        "-724+     627/      -66-609*   -466+  953* -     591*   696",
+        "1695934565+ 1110774670- -603242537* -561540301+-1630721439",
+        "1972989205/ 2000778077/ 702377747+ 1351987289/ -1622777131",
+        mixed.c_str(),
+    };
+    CCalculator calc, heap(0);
+    printf("%12s %12s  %s\n", "arena", "heap", "expression");
+    for (const char *expression : expressions) {
+        size_t before = g_allocations;
+        calc.process(expression);
+        size_t arena = g_allocations - before;
+        before = g_allocations;
+        heap.process(expression);
+        printf("%12zu %12zu  %.60s\n", arena, g_allocations - before, expression);
+    }
+
+    mt19937 gen(9);
+    BigInt x = random_bigint(50, gen), y = random_bigint(40, gen), seven = 7;
+    struct {
+        const char *name;
+        function<BigInt()> run;
+    } ops[] = {
+        {"-(x * y)", [&] { return -(x * y); }},
+        {"abs(x - y) * 7", [&] { return (x - y).abs() * seven; }},
+        {"(x + y) / 7 % y", [&] { return (x + y) / seven % y; }},
+        {"(x + y) / y", [&] { return (x + y) / y; }},
+        {"(x + y) % y", [&] { return (x + y) % y; }},
+        {"y - x + x", [&] { return y - x + x; }},
+        {"-x + y", [&] { return -x + y; }},
+        {"z = x; z -= y; z += x", [&] { BigInt z = x; z -= y; z += x; return z; }},
+    };
+    printf("%12s  %s\n", "allocations", "operation");
+    for (auto &op : ops) {
+        size_t before = g_allocations;
+        op.run();
+        printf("%12zu  %s\n", g_allocations - before, op.name);
+    }
+}
+
+// a^e mod m: квадраты и произведения с полным '%' против контекста модуля
+// с константой Барретта и скользящим окном.
+static void bench_powmod() {
+    mt19937 gen(8);
+    printf("%8s %12s %12s %8s\n", "limbs", "'%', ms", "barrett, ms", "speedup");
+    for (int k : {4, 16, 64, 256}) {
+        BigInt m = random_bigint(k, gen), x = random_bigint(k, gen) % m;
+        BigInt e = random_bigint(k, gen);
+        double plain = time_ms([&] {
+            BigInt res = 1, b = x;
+            for (BigInt t = e; !t.isZero(); t /= 2, b = b * b % m) {
+                if (t % 2) res = res * b % m;
+            }
+        });
+        double barrett = time_ms([&] { BigIntModulus(m).powmod(x, e); });
+        printf("%8d %12.3f %12.3f %8.2f\n", k, plain, barrett, plain / barrett);
+    }
+}
+
+// Выражение из длинных чисел: с ареной на выражение и без нее.
+static void bench_arena() {
+    mt19937 gen(2);
+    string expression;
+    ostringstream out;
+    for (int i = 0; i < 100; ++i) {
+        out << random_bigint(1 + gen() % 30, gen) << " " << "*/"[gen() % 2]
+            << " " << random_bigint(1 + gen() % 30, gen) << " "
+            << "+-"[gen() % 2] << " ";
+    }
+    out << 1;
+    expression = out.str();
+
+    printf("%12s %12s %10s\n", "arena", "allocations", "time, ms");
+    for (size_t size : {0, 1 << 20, 1 << 22}) {
+        CCalculator calc(size);
+        size_t before = g_allocations;
+        calc.process(expression.c_str());
+        size_t allocations = g_allocations - before;
+        double ms = time_ms([&] { calc.process(expression.c_str()); });
+        printf("%12zu %12zu %10.4f\n", size, allocations, ms);
+    }
+}
+
+// Сумма длинного столбца: += на BigInt против BigIntAccumulator, и
+// калькулятор на цепочке сложений и вычитаний.
+static void bench_sum() {
+    mt19937 gen(11);
+    printf("%8s %8s %12s %12s %12s\n", "n", "limbs", "+=, ms", "acc, ms", "calc, ms");
+    for (int n : {1000, 100000, 1000000}) {
+        for (int limbs : {2, 20}) {
+            vector<BigInt> xs;
+            string expression = "0";
+            for (int i = 0; i < n; ++i) {
+                xs.push_back(random_bigint(1 + gen() % limbs, gen));
+                if (gen() % 4 == 0) xs.back() = -xs.back();
+                if (i < 100000) {
+                    ostringstream out;
+                    out << (xs.back() < 0 ? " - " : " + ") << xs.back().abs();
+                    expression += out.str();
+                }
+            }
+            double plain = time_ms([&] {
+                BigInt res;
+                for (const BigInt &x : xs) res += x;
+            });
+            double acc = time_ms([&] {
+                BigIntAccumulator res;
+                for (const BigInt &x : xs) res += x;
+                res.value();
+            });
+            CCalculator calc;
+            double chain = n <= 100000 ? time_ms([&] { calc.process(expression.c_str()); }) : 0;
+            printf("%8d %8d %12.3f %12.3f %12.3f\n", n, limbs, plain, acc, chain);
+        }
+    }
+}
+
+// Числа ограниченной ширины: FixedBigInt<256> на стеке против BigInt,
+// время одной операции в наносекундах и калькулятор на обоих типах.
+static void bench_fixed() {
+    typedef FixedBigInt<256> Fixed;
+    mt19937 gen(10);
+    volatile unsigned long long sink = 0;
+    printf("%8s %8s %12s %12s\n", "digits", "op", "BigInt, ns", "fixed, ns");
+    for (int n : {9, 18, 36}) {
+        BigInt x = random_bigint(n / 9, gen), y = random_bigint((n + 17) / 18, gen);
+        ostringstream xs, ys;
+        xs << x;
+        ys << y;
+        Fixed fx(xs.str()), fy(ys.str());
+        auto row = [&](const char *op, double decimal, double fixed) {
+            printf("%8d %8s %12.1f %12.1f\n", n, op, decimal * 1e3, fixed * 1e3);
+        };
+        row("+", time_ms([&] {
+                for (int i = 0; i < 1000; ++i) sink = sink + (x + y).a[0];
+            }),
+            time_ms([&] {
+                for (int i = 0; i < 1000; ++i) sink = sink + (fx + fy).a[0];
+            }));
+        row("*", time_ms([&] {
+                for (int i = 0; i < 1000; ++i) sink = sink + (x * y).a[0];
+            }),
+            time_ms([&] {
+                for (int i = 0; i < 1000; ++i) sink = sink + (fx * fy).a[0];
+            }));
+        row("/", time_ms([&] {
+                for (int i = 0; i < 1000; ++i) sink = sink + (x / y).a[0];
+            }),
+            time_ms([&] {
+                for (int i = 0; i < 1000; ++i) sink = sink + (fx / fy).a[0];
+            }));
+    }
+
+    ostringstream out;
+    for (int i = 0; i < 100; ++i) {
+        out << random_bigint(1, gen) << " * " << random_bigint(1, gen) << " / "
+            << 1 + gen() % 1000 << " " << "+-"[gen() % 2] << " ";
+    }
+    out << 1;
+    string expression = out.str();
+    CCalculator decimal;
+    CBasicCalculator<Fixed> fixed;
+    printf("%8s %12s %12s\n", "calc", "BigInt, ms", "fixed, ms");
+    printf("%8s %12.4f %12.4f\n", "",
+           time_ms([&] { decimal.process(expression.c_str()); }),
+           time_ms([&] { fixed.process(expression.c_str()); }));
+}
+
+// Нагрузки, где числа в основном копируют: время, походы в кучу и байты
+// за один прогон.  Сравнивать с тем же разделом bench_shared, собранного с
+// BIGINT_SHARED_LIMBS (make bench_shared).
+static void bench_copies() {
+    mt19937 gen(13);
+#ifdef BIGINT_SHARED_LIMBS
+    printf("limbs: shared (BIGINT_SHARED_LIMBS)\n");
+#else
+    printf("limbs: copied\n");
+#endif
+    printf("%10s %8s %12s %12s %12s\n", "workload", "limbs", "time, ms", "allocations",
+           "KiB");
+    for (int limbs : {16, 1000}) {
+        vector<BigInt> xs;
+        for (int i = 0; i < 1000; ++i) xs.push_back(random_bigint(limbs, gen));
+        BigInt divisor = random_bigint(limbs / 2, gen);
+        volatile size_t sink = 0;
+        auto row = [&](const char *name, function<void()> f) {
+            size_t allocations = g_allocations, bytes = g_allocated_bytes;
+            f();
+            allocations = g_allocations - allocations;
+            bytes = g_allocated_bytes - bytes;
+            printf("%10s %8d %12.4f %12zu %12zu\n", name, limbs, time_ms(f), allocations,
+                   bytes / 1024);
+        };
+        row("vector", [&] {
+            vector<BigInt> copy = xs;
+            sink = sink + copy.size();
+        });
+        row("-x, abs", [&] {
+            for (const BigInt &x : xs) sink = sink + (-x).a.size() + x.abs().a.size();
+        });
+        row("by value", [&] {
+            auto size = [](BigInt x) { return x.a.size(); };
+            for (const BigInt &x : xs) sink = sink + size(x);
+        });
+        row("x % d", [&] {
+            for (size_t i = 0; i < 50; ++i) sink = sink + (xs[i] % divisor).a.size();
+        });
+    }
+}
+
+// Сохранение и загрузка чисел: десятичный текст против двоичных лимбов и
+// отображенного в память файла, время на весь набор и размер файла.
+static void bench_serialize() {
+    mt19937 gen(14);
+    const char *text = "/tmp/bench_bigint.txt", *binary = "/tmp/bench_bigint.bin";
+    printf("%8s %8s %12s %12s %12s %12s\n", "count", "limbs", "format", "write, ms",
+           "read, ms", "KiB");
+    for (int limbs : {10, 1000}) {
+        int count = 1000000 / limbs;
+        vector<BigInt> xs;
+        for (int i = 0; i < count; ++i) xs.push_back(random_bigint(1 + gen() % limbs, gen));
+        auto file_kib = [](const char *path) {
+            struct stat st;
+            return stat(path, &st) ? 0 : (long) (st.st_size / 1024);
+        };
+        auto row = [&](const char *format, double write, double read, const char *path) {
+            char written[32] = "-";
+            if (write >= 0) snprintf(written, sizeof(written), "%.3f", write);
+            printf("%8d %8d %12s %12s %12.3f %12ld\n", count, limbs, format, written, read,
+                   file_kib(path));
+        };
+
+        double write = time_ms([&] {
+            ofstream out(text);
+            for (const BigInt &x : xs) out << x << '\n';
+        });
+        double read = time_ms([&] {
+            ifstream in(text);
+            BigInt x;
+            while (in >> x) {
+            }
+        });
+        row("decimal", write, read, text);
+
+        write = time_ms([&] {
+            ofstream out(binary, ios::binary);
+            write_binary_header(out);
+            for (const BigInt &x : xs) write_binary(out, x);
+        });
+        read = time_ms([&] {
+            ifstream in(binary, ios::binary);
+            BigInt x;
+            read_binary_header(in);
+            while (read_binary(in, x)) {
+            }
+        });
+        row("binary", write, read, binary);
+
+        // Открыть, пройти по всем числам и сравнить соседние: лимбы читаются
+        // прямо из отображения, BigInt не создается ни одного.
+        volatile long sink = 0;
+        read = time_ms([&] {
+            BigIntMappedFile file(binary);
+            for (size_t i = 1; i < file.size(); ++i) sink = sink + (file[i - 1] < file[i]);
+        });
+        row("mmap", -1, read, binary);
+    }
+    remove(text);
+    remove(binary);
+}
+
+// Десятичный ввод и вывод одного длинного числа: через строку целиком,
+// как было, против потокового разбора и вывода кусками.  KiB — сколько
+// байт за чтение взято у кучи (строка и лимбы против одних лимбов).
+static void bench_decimal() {
+    mt19937 gen(15);
+    const char *path = "/tmp/bench_bigint_decimal.txt";
+    printf("%10s %10s %12s %12s %12s\n", "digits", "way", "read, ms", "write, ms", "KiB");
+    for (int digits : {100000, 1000000, 10000000}) {
+        BigInt x = random_bigint(digits / BASE_DIGITS, gen);
+        ostringstream text;
+        text << x;
+        istringstream in(text.str());
+        ostringstream out;
+        auto row = [&](const char *way, function<void()> read, function<void()> write) {
+            size_t bytes = g_allocated_bytes;
+            read();
+            bytes = g_allocated_bytes - bytes;
+            printf("%10d %10s %12.3f %12.3f %12zu\n", digits, way, time_ms(read),
+                   time_ms(write), bytes / 1024);
+        };
+        row("string",
+            [&] {
+                in.clear();
+                in.seekg(0);
+                string s;
+                in >> s;
+                BigInt y;
+                y.read(s);
+            },
+            [&] {
+                out.str("");
+                out << (x.a.empty() ? 0 : x.a.back());
+                for (int i = (int) x.a.size() - 2; i >= 0; --i)
+                    out << setw(BASE_DIGITS) << setfill('0') << x.a[i];
+            });
+        row("stream",
+            [&] {
+                in.clear();
+                in.seekg(0);
+                BigInt y;
+                in >> y;
+            },
+            [&] {
+                out.str("");
+                out << x;
+            });
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        write_decimal(fd, x);
+        close(fd);
+        row("fd",
+            [&] {
+                int fd = open(path, O_RDONLY);
+                BigInt y;
+                read_decimal(fd, y);
+                close(fd);
+            },
+            [&] {
+                int fd = open(path, O_WRONLY | O_TRUNC);
+                write_decimal(fd, x);
+                close(fd);
+            });
+    }
+    remove(path);
+}
+
+int main(int argc, char *argv[]) {
+    struct {
+        const char *name;
+        void (*run)();
+    } sections[] = {{"div", bench_div}, {"divisor", bench_divisor},
+                    {"gcd", bench_gcd},
+                    {"sqrt", bench_sqrt},
+                    {"tree", bench_tree},
+                    {"sum", bench_sum},
+                    {"karatsuba", bench_karatsuba},
+                    {"unbalanced", bench_unbalanced},
+                    {"square", bench_square},
+                    {"threads", bench_threads},
+                    {"repeat", bench_repeat},
+                    {"binary", bench_binary},
+                    {"fixed", bench_fixed},
+                    {"kernels", bench_kernels},
+                    {"alloc", bench_alloc},
+                    {"copies", bench_copies},
+                    {"serialize", bench_serialize},
+                    {"decimal", bench_decimal},
+                    {"arena", bench_arena},
+                    {"powmod", bench_powmod}};
+
+    for (auto &section : sections) {
+        if (argc > 1 && strcmp(argv[1], section.name)) continue;
+        printf("== %s\n", section.name);
+        section.run();
+    }
+    return 0;
+}
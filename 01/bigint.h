@@ -6,6 +6,7 @@
 // - Fix overflow bug in fft.
 // - Fix bug in initialization from long long.
 // - Optimized operators + - *.
+// - Exact three-prime NTT multiplication instead of FFT for large operands.
 //
 // Tested:
 // - https://www.e-olymp.com/en/problems/266: Comparison
@@ -23,12 +24,629 @@
 // - SPOJ MUL, VFMUL: Multiplication.
 // - SPOJ FDIV, VFDIV: Division.
 
+#include "bigint_tuning.h"
+
+// AVX2 limb kernels are compiled with a target attribute and picked at run
+// time, so the rest of the file does not depend on -mavx2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BIGINT_AVX2_KERNELS 1
+#include <immintrin.h>
+#endif
+
 const int BASE_DIGITS = 9;
 const int BASE = 1000000000;
 
+// -------------------- Memory resources --------------------
+// Source of heap limbs for LimbVector, a C++14 stand-in for
+// std::pmr::memory_resource.  allocate() may return nullptr, then the limbs
+// come from the ordinary heap instead.  Blocks must be aligned for long
+// long: BigIntAccumulator keeps its 64-bit limbs in them too.
+class LimbResource {
+  public:
+    virtual ~LimbResource() {}
+    virtual void *allocate(size_t bytes) = 0;
+    virtual void deallocate(void *p, size_t bytes) = 0;
+
+    // Resource for new limbs on this thread, nullptr means the heap.
+    static LimbResource *&current() {
+        static thread_local LimbResource *resource = nullptr;
+        return resource;
+    }
+};
+
+// Sends all limbs allocated during its lifetime to the given resource.
+// Every block remembers where it came from, so numbers may outlive the
+// scope as long as the resource itself is alive.
+class LimbResourceScope {
+  public:
+    explicit LimbResourceScope(LimbResource *resource)
+        : previous_(LimbResource::current()) {
+        LimbResource::current() = resource;
+    }
+    ~LimbResourceScope() {
+        LimbResource::current() = previous_;
+    }
+    LimbResourceScope(const LimbResourceScope &) = delete;
+    LimbResourceScope &operator=(const LimbResourceScope &) = delete;
+
+  private:
+    LimbResource *previous_;
+};
+
+// -------------------- Limb storage --------------------
+// The subset of vector<int> that BigInt uses.  Up to INLINE_LIMBS limbs are
+// kept inside the object, so small numbers never touch the heap.
+//
+// With BIGINT_SHARED_LIMBS defined (and <atomic> included before this
+// header), heap blocks are copy-on-write: a block starts with a reference
+// count, a copy shares the block in O(1) and the first mutable access to a
+// shared block (non-const data(), [], begin(), end(), back(), or any resize)
+// detaches it.  Only blocks from the current LimbResource are shared, so a
+// copy made outside a LimbResourceScope still moves the limbs out of the
+// arena.  A pointer from a mutable accessor must not be written through
+// after the vector has been copied; the hot loops take such a pointer once
+// rather than paying for the check on every [].
+class LimbVector {
+  public:
+    static const int INLINE_LIMBS = 8;
+
+    typedef int value_type;
+    typedef int *iterator;
+    typedef const int *const_iterator;
+
+    LimbVector()
+        : data_(inline_), size_(0), capacity_(INLINE_LIMBS), resource_(nullptr) {}
+    LimbVector(const LimbVector &v) : LimbVector() {
+        copy_from(v);
+    }
+    LimbVector(LimbVector &&v) noexcept : LimbVector() {
+        take(v);
+    }
+    ~LimbVector() {
+        release();
+    }
+
+    LimbVector &operator=(const LimbVector &v) {
+        if (this != &v) copy_from(v);
+        return *this;
+    }
+    LimbVector &operator=(LimbVector &&v) noexcept {
+        if (this != &v) {
+            release();
+            take(v);
+        }
+        return *this;
+    }
+    LimbVector &operator=(const vector<int> &v) {
+        assign(v.begin(), v.end());
+        return *this;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    size_t capacity() const {
+        return capacity_;
+    }
+    int *data() {
+        unshare();
+        return data_;
+    }
+    const int *data() const {
+        return data_;
+    }
+    int *begin() {
+        unshare();
+        return data_;
+    }
+    const int *begin() const {
+        return data_;
+    }
+    int *end() {
+        unshare();
+        return data_ + size_;
+    }
+    const int *end() const {
+        return data_ + size_;
+    }
+    int &operator[](size_t i) {
+        unshare();
+        return data_[i];
+    }
+    const int &operator[](size_t i) const {
+        return data_[i];
+    }
+    int &back() {
+        unshare();
+        return data_[size_ - 1];
+    }
+    const int &back() const {
+        return data_[size_ - 1];
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+    void push_back(int x) {
+        if (size_ == capacity_)
+            reserve(2 * capacity_);
+        else
+            unshare();
+        data_[size_++] = x;
+    }
+    void pop_back() {
+        --size_;
+    }
+    void reserve(size_t n) {
+        if (n > capacity_) reallocate(n);
+    }
+    void resize(size_t n, int x = 0) {
+        if (n > capacity_)
+            reserve(max(n, 2 * capacity_));
+        else
+            unshare();
+        if (n > size_) fill(data_ + size_, data_ + n, x);
+        size_ = n;
+    }
+    void assign(size_t n, int x) {
+        clear();
+        resize(n, x);
+    }
+    template <typename It, typename = typename std::enable_if<
+                               !std::is_integral<It>::value>::type>
+    void assign(It first, It last) {
+        size_t n = distance(first, last);
+        // The old limbs are not needed, a shared block is just dropped.
+        if (shared()) release();
+        clear();
+        reserve(n);
+        copy(first, last, data_);
+        size_ = n;
+    }
+
+  private:
+#ifdef BIGINT_SHARED_LIMBS
+    // Ints in front of a heap block: its atomic reference count.
+    static const int HEADER = 2;
+#else
+    static const int HEADER = 0;
+#endif
+
+    int *data_;
+    size_t size_;
+    size_t capacity_;
+    // Where the heap block came from, nullptr for operator new[].
+    LimbResource *resource_;
+    int inline_[INLINE_LIMBS];
+
+#ifdef BIGINT_SHARED_LIMBS
+    atomic<int> &refs() const {
+        return *reinterpret_cast<atomic<int> *>(data_ - HEADER);
+    }
+    bool shared() const {
+        return data_ != inline_ && refs().load(memory_order_relaxed) > 1;
+    }
+    bool last_reference() {
+        return refs().fetch_sub(1, memory_order_acq_rel) == 1;
+    }
+#else
+    bool shared() const {
+        return false;
+    }
+    bool last_reference() {
+        return true;
+    }
+#endif
+
+    void unshare() {
+        if (shared()) reallocate(capacity_);
+    }
+
+    // Moves the limbs into a fresh block of n >= size_ limbs of our own.
+    void reallocate(size_t n) {
+        LimbResource *resource = LimbResource::current();
+        size_t bytes = (n + HEADER) * sizeof(int);
+        int *p = resource ? (int *) resource->allocate(bytes) : nullptr;
+        if (!p) {
+            resource = nullptr;
+            p = new int[n + HEADER];
+        }
+#ifdef BIGINT_SHARED_LIMBS
+        new (p) atomic<int>(1);
+#endif
+        p += HEADER;
+        copy(data_, data_ + size_, p);
+        release();
+        data_ = p;
+        capacity_ = n;
+        resource_ = resource;
+    }
+
+    void copy_from(const LimbVector &v) {
+#ifdef BIGINT_SHARED_LIMBS
+        if (v.data_ != v.inline_ && v.resource_ == LimbResource::current()) {
+            if (data_ == v.data_) {
+                size_ = v.size_;
+                return;
+            }
+            v.refs().fetch_add(1, memory_order_relaxed);
+            release();
+            data_ = v.data_;
+            size_ = v.size_;
+            capacity_ = v.capacity_;
+            resource_ = v.resource_;
+            return;
+        }
+#endif
+        assign(v.begin(), v.end());
+    }
+
+    // Drops our reference to the heap block, frees it if it was the last.
+    void release() {
+        if (data_ != inline_ && last_reference()) {
+            if (resource_)
+                resource_->deallocate(data_ - HEADER, (capacity_ + HEADER) * sizeof(int));
+            else
+                delete[] (data_ - HEADER);
+        }
+        data_ = inline_;
+        capacity_ = INLINE_LIMBS;
+        resource_ = nullptr;
+    }
+    // Steals the contents of v (*this must be inline and empty).
+    void take(LimbVector &v) {
+        if (v.data_ == v.inline_) {
+            copy(v.data_, v.data_ + v.size_, inline_);
+        } else {
+            data_ = v.data_;
+            capacity_ = v.capacity_;
+            resource_ = v.resource_;
+            v.data_ = v.inline_;
+            v.capacity_ = INLINE_LIMBS;
+            v.resource_ = nullptr;
+        }
+        size_ = v.size_;
+        v.size_ = 0;
+    }
+};
+
+// -------------------- Transform tables --------------------
+// Tables for transforms of length 2^log, built once and shared between
+// calls and threads.  All the caches (bit reversal, FFT twiddles, one per
+// NTT prime) draw on one budget of MAX_BYTES: the most recently used tables
+// are kept while they fit together, and a table larger than the whole
+// budget is built for its caller and never kept.  An evicted table still
+// held by a running transform lives on through its shared_ptr.
+class TransformTableBudget {
+  public:
+    static const size_t MAX_BYTES = 1 << 25;
+
+    static TransformTableBudget &instance() {
+        static TransformTableBudget budget;
+        return budget;
+    }
+
+    // The table of owner for 2^log.  On a miss build(bytes) makes it, with
+    // the lock released, and reports its size.
+    template <typename Build>
+    shared_ptr<const void> get(const void *owner, int log, Build build) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (shared_ptr<const void> table = find(owner, log)) return table;
+        }
+        size_t bytes = 0;
+        shared_ptr<const void> table = build(bytes);
+        if (bytes > MAX_BYTES) return table;
+
+        lock_guard<mutex> lock(mutex_);
+        // Another thread may have built the same table meanwhile.
+        if (shared_ptr<const void> kept = find(owner, log)) return kept;
+        entries_.push_back(Entry{owner, log, table, bytes});
+        bytes_ += bytes;
+        while (bytes_ > MAX_BYTES) {
+            bytes_ -= entries_.front().bytes;
+            entries_.erase(entries_.begin());
+        }
+        return table;
+    }
+
+    // Drops the tables of owner, which is going away.
+    void forget(const void *owner) {
+        lock_guard<mutex> lock(mutex_);
+        for (size_t i = 0; i < entries_.size();)
+            if (entries_[i].owner == owner) {
+                bytes_ -= entries_[i].bytes;
+                entries_.erase(entries_.begin() + i);
+            } else {
+                ++i;
+            }
+    }
+
+    // Bytes kept for owner, for all the caches when owner is nullptr.
+    size_t bytes(const void *owner = nullptr) {
+        lock_guard<mutex> lock(mutex_);
+        if (!owner) return bytes_;
+        size_t res = 0;
+        for (const Entry &e : entries_)
+            if (e.owner == owner) res += e.bytes;
+        return res;
+    }
+
+  private:
+    struct Entry {
+        const void *owner;
+        int log;
+        shared_ptr<const void> table;
+        size_t bytes;
+    };
+
+    mutex mutex_;
+    vector<Entry> entries_; // least recently used first
+    size_t bytes_ = 0;
+
+    // Moves a hit to the back; called with the lock held.
+    shared_ptr<const void> find(const void *owner, int log) {
+        for (size_t i = 0; i < entries_.size(); ++i)
+            if (entries_[i].owner == owner && entries_[i].log == log) {
+                rotate(entries_.begin() + i, entries_.begin() + i + 1, entries_.end());
+                return entries_.back().table;
+            }
+        return nullptr;
+    }
+};
+
+// One kind of table, with its entries in the shared budget.
+template <typename T>
+class TransformTableCache {
+  public:
+    // The budget is made first, so it is destroyed after every cache.
+    TransformTableCache() {
+        TransformTableBudget::instance();
+    }
+    ~TransformTableCache() {
+        TransformTableBudget::instance().forget(this);
+    }
+    TransformTableCache(const TransformTableCache &) = delete;
+    TransformTableCache &operator=(const TransformTableCache &) = delete;
+
+    // The table for 2^log, make(n) builds it on a miss.
+    template <typename Make>
+    shared_ptr<const vector<T> > get(int log, Make make) {
+        return static_pointer_cast<const vector<T> >(
+            TransformTableBudget::instance().get(this, log, [&](size_t &bytes) {
+                auto table = make_shared<const vector<T> >(make(1 << log));
+                bytes = table->size() * sizeof(T);
+                return table;
+            }));
+    }
+
+    // Bytes of this kind of table kept now.
+    size_t bytes() {
+        return TransformTableBudget::instance().bytes(this);
+    }
+};
+
+// -------------------- Transforms --------------------
+// What the transforms of BigInt and BinaryBigInt share: worker threads,
+// the bit-reversal permutation, butterfly stages and an exact convolution
+// modulo three NTT-friendly primes, its tables cached in the budget above.
+// The callers only differ in how they cut their limbs into coefficients
+// and carry the convolution back into limbs.
+struct Transforms {
+    // -------------------- Threads --------------------
+    // Fewer items than this for a thread are not worth starting it.
+    static const long long MIN_PER_THREAD = 1 << 14;
+
+    // Calls f(from, to) on [0, n) cut into `threads` contiguous ranges, the
+    // last one on the calling thread.  Too little work is not worth a thread.
+    template <typename F>
+    static void parallel_for(long long n, int threads, F f) {
+        threads = (int) max(1LL, min<long long>(threads, n / MIN_PER_THREAD));
+        vector<thread> pool;
+        for (int t = 0; t + 1 < threads; ++t)
+            pool.emplace_back(f, n * t / threads, n * (t + 1) / threads);
+        f(n * (threads - 1) / threads, n);
+        for (thread &worker : pool)
+            worker.join();
+    }
+
+    // -------------------- Butterflies --------------------
+    static int log2_ceil(int n) {
+        int log = 0;
+        while ((1 << log) < n)
+            ++log;
+        return log;
+    }
+
+    // The bit-reversal permutation for transforms of length n = 2^log.
+    static shared_ptr<const vector<int> > bit_reversal(int log) {
+        static TransformTableCache<int> cache;
+        return cache.get(log, [](int n) {
+            vector<int> rev(n);
+            for (int i = 1; i < n; ++i)
+                rev[i] = (rev[i >> 1] >> 1) | (i & 1 ? n >> 1 : 0);
+            return rev;
+        });
+    }
+
+    // Puts a[0 .. n) in bit-reversed order.
+    template <typename T>
+    static void bit_reverse(T *a, int n) {
+        shared_ptr<const vector<int> > rev = bit_reversal(log2_ceil(n));
+        for (int i = 1; i < n; ++i)
+            if (i < (*rev)[i])
+                swap(a[i], a[(*rev)[i]]);
+    }
+
+    // The butterfly stages of a transform of length n over a, already in
+    // bit-reversed order; bf(x, y, w) does one pair.  Butterflies are
+    // numbered across all blocks of a stage, so a stage splits evenly
+    // between threads even when there are few long blocks.  Stages shorter
+    // than n / blocks stay inside blocks of that length, and each thread runs
+    // all of them on its own block: threads are started once for those and
+    // once for each of the last log2(blocks) stages, not for every stage.
+    template <typename T, typename W, typename Butterfly>
+    static void butterfly_stages(T *a, int n, const W *w, int threads, Butterfly bf) {
+        auto stage = [&](int len, long long from, long long to) {
+            int half = len / 2;
+            int j = (int) (from % half);
+            T *x = a + from / half * len;
+            for (long long t = from; t < to; x += len, j = 0) {
+                int end = (int) min<long long>(half, j + to - t);
+                T *y = x + half;
+                for (; j < end; ++j, ++t)
+                    bf(x[j], y[j], w[half + j]);
+            }
+        };
+        int blocks = 1;
+        while (2 * blocks <= threads && n / 2 / (2 * blocks) >= MIN_PER_THREAD)
+            blocks *= 2;
+        int local = n / blocks;
+        parallel_for(n / 2, blocks, [&](long long from, long long to) {
+            for (int len = 2; len <= local; len <<= 1)
+                stage(len, from, to);
+        });
+        for (int len = 2 * local; len <= n; len <<= 1)
+            parallel_for(n / 2, threads,
+                         [&](long long from, long long to) { stage(len, from, to); });
+    }
+
+    // -------------------- Number-theoretic transform --------------------
+    // Primes c * 2^k + 1 with a root of unity of order 2^MAX_LOG each.  A
+    // coefficient of a convolution is recovered exactly while it stays below
+    // P1 * P2 * P3 > 2^86.
+    static const unsigned P1 = 2013265921; // 15 * 2^27 + 1, root 31
+    static const unsigned P2 = 469762049;  // 7 * 2^26 + 1, root 3
+    static const unsigned P3 = 167772161;  // 5 * 2^25 + 1, root 3
+    static const int MAX_LOG = 25;
+
+    static constexpr unsigned pow_mod(unsigned long long b, unsigned long long e, unsigned mod) {
+        unsigned long long r = 1;
+        for (b %= mod; e; e >>= 1, b = b * b % mod)
+            if (e & 1) r = r * b % mod;
+        return (unsigned) r;
+    }
+
+    // Powers of the root of order n = 2^log laid out stage by stage, the
+    // ones for the stage of length len at [len / 2, len).  Each stage takes
+    // every second root of the next one.
+    template <unsigned MOD, unsigned ROOT>
+    static shared_ptr<const vector<unsigned> > ntt_twiddles(int log) {
+        static TransformTableCache<unsigned> cache;
+        return cache.get(log, [](int n) {
+            vector<unsigned> w(max(n, 2));
+            unsigned long long root = pow_mod(ROOT, (MOD - 1) / n, MOD), cur = 1;
+            for (int j = 0; j < n / 2; ++j, cur = cur * root % MOD)
+                w[n / 2 + j] = (unsigned) cur;
+            for (int i = n / 2 - 1; i >= 1; --i)
+                w[i] = w[2 * i];
+            return w;
+        });
+    }
+
+    template <unsigned MOD, unsigned ROOT>
+    static void ntt(vector<unsigned> &a, bool invert, int threads = 1) {
+        int n = (int) a.size();
+        bit_reverse(a.data(), n);
+        shared_ptr<const vector<unsigned> > twiddles = ntt_twiddles<MOD, ROOT>(log2_ceil(n));
+        butterfly_stages(a.data(), n, twiddles->data(), threads,
+                         [](unsigned &x, unsigned &y, unsigned w) {
+                             unsigned u = x;
+                             unsigned v = (unsigned) ((unsigned long long) y * w % MOD);
+                             x = u + v >= MOD ? u + v - MOD : u + v;
+                             y = u >= v ? u - v : u + MOD - v;
+                         });
+        // The inverse transform is the forward one read backwards.
+        if (invert) {
+            reverse(a.begin() + 1, a.end());
+            unsigned long long inv_n = pow_mod(n, MOD - 2, MOD);
+            parallel_for(n, threads, [&](long long from, long long to) {
+                for (long long i = from; i < to; ++i)
+                    a[i] = (unsigned) (a[i] * inv_n % MOD);
+            });
+        }
+    }
+
+    // Cyclic convolution of length n modulo MOD, result in fa.  The same
+    // span passed twice is a square and needs only one forward transform.
+    template <unsigned MOD, unsigned ROOT, typename T>
+    static void convolve_ntt(const T *a, int na, const T *b, int nb, int n,
+                             vector<unsigned> &fa, int threads) {
+        fa.assign(n, 0);
+        for (int i = 0; i < na; ++i) fa[i] = (unsigned) (a[i] % MOD);
+        ntt<MOD, ROOT>(fa, false, threads);
+        if (a == b && na == nb) {
+            for (int i = 0; i < n; ++i)
+                fa[i] = (unsigned) ((unsigned long long) fa[i] * fa[i] % MOD);
+        } else {
+            vector<unsigned> fb(n, 0);
+            for (int i = 0; i < nb; ++i) fb[i] = (unsigned) (b[i] % MOD);
+            ntt<MOD, ROOT>(fb, false, threads);
+            for (int i = 0; i < n; ++i)
+                fa[i] = (unsigned) ((unsigned long long) fa[i] * fb[i] % MOD);
+        }
+        ntt<MOD, ROOT>(fa, true, threads);
+    }
+
+    // The cyclic convolution of a and b of length n <= 2^MAX_LOG modulo each
+    // prime, in f1, f2, f3.  With several threads the three primes are
+    // convolved concurrently and share the rest of the threads for their
+    // butterflies.
+    template <typename T>
+    static void convolve_three(const T *a, int na, const T *b, int nb, int n,
+                               vector<unsigned> &f1, vector<unsigned> &f2,
+                               vector<unsigned> &f3, int threads = 1) {
+        if (threads > 1 && n >= (1 << 14)) {
+            int share = max(1, threads / 3);
+            thread t2([&] { convolve_ntt<P2, 3>(a, na, b, nb, n, f2, share); });
+            thread t3([&] { convolve_ntt<P3, 3>(a, na, b, nb, n, f3, share); });
+            convolve_ntt<P1, 31>(a, na, b, nb, n, f1, max(1, threads - 2 * share));
+            t2.join();
+            t3.join();
+        } else {
+            convolve_ntt<P1, 31>(a, na, b, nb, n, f1, 1);
+            convolve_ntt<P2, 3>(a, na, b, nb, n, f2, 1);
+            convolve_ntt<P3, 3>(a, na, b, nb, n, f3, 1);
+        }
+    }
+
+    // Garner: the x < P1 * P2 * P3 with residues r1, r2, r3 is
+    // r1 + P1 * (v2 + P2 * v3) with v2 < P2 and v3 < P3.
+    static void garner(unsigned r1, unsigned r2, unsigned r3, unsigned long long &v2,
+                       unsigned long long &v3) {
+        constexpr unsigned long long inv_p1 = pow_mod(P1, P2 - 2, P2);
+        constexpr unsigned long long inv_p1p2 =
+            pow_mod((unsigned long long) P1 * P2 % P3, P3 - 2, P3);
+        v2 = (r2 + P2 - r1 % P2) * inv_p1 % P2;
+        v3 = (r3 + 2ULL * P3 - r1 % P3 - v2 * (P1 % P3) % P3) * inv_p1p2 % P3;
+    }
+};
+
+// -------------------- Division by a limb --------------------
+// Division by a fixed d through inv = (2^64 - 1) / d (Granlund, Montgomery):
+// the high word of num * inv is num / d or one less, so a multiplication and
+// a compare replace the hardware division.  Good for any num < 2^64, in
+// particular for the two-limb numerators num < d * BASE of long division.
+struct LimbDivisor {
+    unsigned long long d, inv;
+
+    explicit LimbDivisor(unsigned long long d = 1) : d(d), inv(~0ULL / d) {}
+
+    void divide(unsigned long long num, long long &q, long long &r) const {
+        unsigned long long qq = (unsigned long long) (((unsigned __int128) num * inv) >> 64);
+        unsigned long long rr = num - qq * d;
+        if (rr >= d) ++qq, rr -= d;
+        q = qq;
+        r = rr;
+    }
+};
+
 struct BigInt {
     int sign;
-    vector<int> a;
+    LimbVector a;
 
     // -------------------- Constructors -------------------- 
     // Default constructor.
@@ -73,19 +691,129 @@ struct BigInt {
         }
         trim();
     }
+
+    // Builds a number from decimal text fed in pieces of any size, so the
+    // text never has to be in memory whole.  Digits are packed nine to a limb
+    // in reading order, that is aligned to the first digit rather than the
+    // last; finish() reverses the limbs and divides by the power of ten the
+    // alignment was off, so the limbs of the target are the only storage.
+    class DecimalReader {
+      public:
+        explicit DecimalReader(BigInt &x) : x_(x) {
+            x_.sign = 1;
+            x_.a.clear();
+        }
+
+        // Signs, then digits; false (and c is not taken) on anything else.
+        bool put(char c) {
+            if (c >= '0' && c <= '9') {
+                digits_ = true;
+                chunk_ = chunk_ * 10 + (c - '0');
+                if (++chunk_digits_ == BASE_DIGITS) {
+                    x_.a.push_back(chunk_);
+                    chunk_ = chunk_digits_ = 0;
+                }
+                return true;
+            }
+            if (!digits_ && (c == '-' || c == '+')) {
+                if (c == '-') x_.sign = -x_.sign;
+                return true;
+            }
+            return false;
+        }
+        // The number of chars of [p, p + n) taken, less than n when the
+        // number ends inside.
+        size_t feed(const char *p, size_t n) {
+            size_t i = 0;
+            while (i < n && put(p[i]))
+                ++i;
+            return i;
+        }
+
+        // Puts the limbs in place, false if there were no digits.
+        bool finish() {
+            int shift = 0;
+            if (chunk_digits_) {
+                shift = BASE_DIGITS - chunk_digits_;
+                x_.a.push_back(chunk_ * pow10(shift));
+            }
+            reverse(x_.a.begin(), x_.a.end());
+            if (shift) x_ /= pow10(shift);
+            x_.trim();
+            return digits_;
+        }
+
+      private:
+        BigInt &x_;
+        bool digits_ = false;
+        int chunk_ = 0, chunk_digits_ = 0;
+
+        static int pow10(int k) {
+            int res = 1;
+            while (k--)
+                res *= 10;
+            return res;
+        }
+    };
+
+    // Leading whitespace, signs and digits straight from the stream buffer;
+    // the first char after the digits stays in the stream.  Nothing is
+    // reserved up front: what is left in the stream may be many numbers, not
+    // this one.  The limbs grow by doubling, so while the last growth copies
+    // them a long number takes up to about three times its final limb
+    // vector; read_decimal in bigint_serialize.h reserves exactly for a
+    // regular file.
     friend istream& operator>>(istream &stream, BigInt &v) {
-        string s;
-        stream >> s;
-        v.read(s);
+        istream::sentry sentry(stream);
+        if (!sentry) return stream;
+        DecimalReader reader(v);
+        streambuf *buf = stream.rdbuf();
+        for (int c = buf->sgetc();; c = buf->snextc()) {
+            if (c == char_traits<char>::eof()) {
+                stream.setstate(ios::eofbit);
+                break;
+            }
+            if (!reader.put((char) c)) break;
+        }
+        if (!reader.finish()) stream.setstate(ios::failbit);
         return stream;
     }
 
+    // Decimal digits of sign and n limbs, handed to sink(const char *, size_t)
+    // a few kilobytes at a time from a buffer on the stack.
+    template <typename Sink>
+    static void write_decimal(int sign, const int *limbs, int n, Sink sink) {
+        const int BUFFER = 4096;
+        char buffer[BUFFER];
+        int len = 0;
+        bool zero = n == 0 || (n == 1 && !limbs[0]);
+        if (sign == -1 && !zero) buffer[len++] = '-';
+        int top = n ? limbs[n - 1] : 0;
+        char digits[BASE_DIGITS];
+        int k = 0;
+        do {
+            digits[k++] = (char) ('0' + top % 10);
+            top /= 10;
+        } while (top);
+        while (k)
+            buffer[len++] = digits[--k];
+        for (int i = n - 2; i >= 0; --i) {
+            if (len > BUFFER - BASE_DIGITS) {
+                sink(buffer, len);
+                len = 0;
+            }
+            for (int j = BASE_DIGITS - 1, x = limbs[i]; j >= 0; --j, x /= 10)
+                buffer[len + j] = (char) ('0' + x % 10);
+            len += BASE_DIGITS;
+        }
+        sink(buffer, len);
+    }
+    template <typename Sink> void write_decimal(Sink sink) const {
+        write_decimal(sign, a.data(), a.size(), sink);
+    }
+
     friend ostream& operator<<(ostream &stream, const BigInt &v) {
-        if (v.sign == -1 && !v.isZero())
-            stream << '-';
-        stream << (v.a.empty() ? 0 : v.a.back());
-        for (int i = (int) v.a.size() - 2; i >= 0; --i)
-            stream << setw(BASE_DIGITS) << setfill('0') << v.a[i];
+        v.write_decimal([&](const char *p, size_t n) { stream.write(p, n); });
         return stream;
     }
 
@@ -134,24 +862,198 @@ struct BigInt {
         return 0;
     }
 
+    // -------------------- Limb kernels --------------------
+    // Carry loops over a whole span of limbs: a += b, a -= b and a *= v.
+    // The scalar versions are the reference, the AVX2 ones take 8 limbs at
+    // a time and give the same limbs and carries.
+    static int limbs_add_scalar(int *a, const int *b, int n, int carry) {
+        for (int i = 0; i < n; ++i) {
+            a[i] += b[i] + carry;
+            carry = a[i] >= BASE;
+            if (carry) a[i] -= BASE;
+        }
+        return carry;
+    }
+
+    static int limbs_sub_scalar(int *a, const int *b, int n, int borrow) {
+        for (int i = 0; i < n; ++i) {
+            a[i] -= b[i] + borrow;
+            borrow = a[i] < 0;
+            if (borrow) a[i] += BASE;
+        }
+        return borrow;
+    }
+
+    // a = a * v + carry for 0 <= v, carry < BASE, returns the new carry.
+    static int limbs_mul_small_scalar(int *a, int n, int v, int carry) {
+        for (int i = 0; i < n; ++i) {
+            long long cur = a[i] * (long long) v + carry;
+            carry = (int) (cur / BASE);
+            a[i] = (int) (cur % BASE);
+        }
+        return carry;
+    }
+
+#ifdef BIGINT_AVX2_KERNELS
+    // Brings 8 limbs t[i] < 2 * BASE into range.  Lane i generates a carry
+    // when t[i] >= BASE and passes one through when t[i] == BASE - 1; with
+    // those as bit masks G and P the carries into all lanes come out of one
+    // integer addition, as in a carry-lookahead adder:
+    // (X + G + carry) ^ X ^ G with X = G | P.
+    __attribute__((target("avx2"))) static __m256i normalize_avx2(__m256i t, int &carry) {
+        const __m256i base = _mm256_set1_epi32(BASE);
+        const __m256i top = _mm256_set1_epi32(BASE - 1);
+        const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        unsigned g = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(t, top)));
+        unsigned p = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(t, top)));
+        unsigned x = g | p, sum = x + g + carry;
+        unsigned in = (sum ^ x ^ g) & 0xFF;
+        unsigned out = (in >> 1) | (sum >> 1 & 0x80);
+        carry = sum >> 8 & 1;
+        // -1 in the lanes whose bit is set.
+        __m256i cin = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(in), lanes), lanes);
+        __m256i cout = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(out), lanes), lanes);
+        t = _mm256_sub_epi32(t, cin);
+        return _mm256_sub_epi32(t, _mm256_and_si256(cout, base));
+    }
+
+    __attribute__((target("avx2"))) static int limbs_add_avx2(int *a, const int *b, int n,
+                                                               int carry) {
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+            _mm256_storeu_si256((__m256i *) (a + i), normalize_avx2(_mm256_add_epi32(x, y), carry));
+        }
+        return limbs_add_scalar(a + i, b + i, n - i, carry);
+    }
+
+    // a - b = a + (BASE - 1 - b) + 1 - BASE limb by limb: an addition with
+    // the carry meaning "no borrow".
+    __attribute__((target("avx2"))) static int limbs_sub_avx2(int *a, const int *b, int n,
+                                                               int borrow) {
+        const __m256i top = _mm256_set1_epi32(BASE - 1);
+        int carry = 1 - borrow, i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+            __m256i t = _mm256_add_epi32(x, _mm256_sub_epi32(top, y));
+            _mm256_storeu_si256((__m256i *) (a + i), normalize_avx2(t, carry));
+        }
+        return limbs_sub_scalar(a + i, b + i, n - i, 1 - carry);
+    }
+
+    // Products split as a[i] * v = hi[i] * BASE + lo[i] with the quotient
+    // estimated in doubles and corrected exactly in 64-bit lanes; then
+    // lo[i] + hi[i - 1] < 2 * BASE is normalized like a sum.
+    __attribute__((target("avx2"))) static __m128i split_avx2(__m128i x, __m256i v, __m256d vd,
+                                                               __m128i &hi) {
+        const __m256i base = _mm256_set1_epi64x(BASE);
+        const __m256i below = _mm256_set1_epi64x(BASE - 1);
+        const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        __m256i p = _mm256_mul_epu32(_mm256_cvtepu32_epi64(x), v);
+        __m256d qd = _mm256_mul_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(x), vd),
+                                   _mm256_set1_pd(1.0 / BASE));
+        __m256i q = _mm256_cvtepu32_epi64(_mm256_cvttpd_epi32(qd));
+        __m256i r = _mm256_sub_epi64(p, _mm256_mul_epu32(q, base));
+        // The estimate is off by at most one either way.
+        __m256i low = _mm256_cmpgt_epi64(_mm256_setzero_si256(), r);
+        r = _mm256_add_epi64(r, _mm256_and_si256(low, base));
+        q = _mm256_add_epi64(q, low);
+        __m256i high = _mm256_cmpgt_epi64(r, below);
+        r = _mm256_sub_epi64(r, _mm256_and_si256(high, base));
+        q = _mm256_sub_epi64(q, high);
+        hi = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(q, pack));
+        return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(r, pack));
+    }
+
+    __attribute__((target("avx2"))) static int limbs_mul_small_avx2(int *a, int n, int v,
+                                                                     int carry) {
+        const __m256i vv = _mm256_set1_epi64x(v);
+        const __m256d vd = _mm256_set1_pd(v);
+        const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+        int hi_prev = carry, bit = 0, i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i hi0, hi1;
+            __m128i lo0 = split_avx2(_mm_loadu_si128((const __m128i *) (a + i)), vv, vd, hi0);
+            __m128i lo1 = split_avx2(_mm_loadu_si128((const __m128i *) (a + i + 4)), vv, vd, hi1);
+            __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(lo0), lo1, 1);
+            __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(hi0), hi1, 1);
+            hi = _mm256_permutevar8x32_epi32(hi, rotate);
+            int next = _mm256_extract_epi32(hi, 0);
+            hi = _mm256_insert_epi32(hi, hi_prev, 0);
+            hi_prev = next;
+            _mm256_storeu_si256((__m256i *) (a + i), normalize_avx2(_mm256_add_epi32(lo, hi), bit));
+        }
+        return limbs_mul_small_scalar(a + i, n - i, v, hi_prev + bit);
+    }
+
+    static bool cpu_has_avx2() {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+#else
+    static bool cpu_has_avx2() {
+        return false;
+    }
+#endif
+
+    // Kernels for this CPU, switched off by hand to compare or measure.
+    struct LimbKernels {
+        int (*add)(int *a, const int *b, int n, int carry);
+        int (*sub)(int *a, const int *b, int n, int borrow);
+        int (*mul_small)(int *a, int n, int v, int carry);
+    };
+    static LimbKernels &limb_kernels() {
+        static LimbKernels kernels = simd_kernels(cpu_has_avx2());
+        return kernels;
+    }
+    static LimbKernels simd_kernels(bool avx2) {
+#ifdef BIGINT_AVX2_KERNELS
+        if (avx2) return {limbs_add_avx2, limbs_sub_avx2, limbs_mul_small_avx2};
+#endif
+        return {limbs_add_scalar, limbs_sub_scalar, limbs_mul_small_scalar};
+    }
+
+    // Short spans stay inline, the vector kernels only pay off on long ones.
+    static const int LIMB_KERNEL_THRESHOLD = 16;
+    static int limbs_add(int *a, const int *b, int n, int carry) {
+        if (n < LIMB_KERNEL_THRESHOLD) return limbs_add_scalar(a, b, n, carry);
+        return limb_kernels().add(a, b, n, carry);
+    }
+    static int limbs_sub(int *a, const int *b, int n, int borrow) {
+        if (n < LIMB_KERNEL_THRESHOLD) return limbs_sub_scalar(a, b, n, borrow);
+        return limb_kernels().sub(a, b, n, borrow);
+    }
+    static int limbs_mul_small(int *a, int n, int v, int carry) {
+        if (n < LIMB_KERNEL_THRESHOLD) return limbs_mul_small_scalar(a, n, v, carry);
+        return limb_kernels().mul_small(a, n, v, carry);
+    }
+
     // -------------------- Unary operator - and operators +- --------------------
-    BigInt operator-() const {
+    BigInt operator-() const & {
         BigInt res = *this;
         if (isZero()) return res;
 
         res.sign = -sign;
         return res;
     }
+    // A temporary is negated in place and handed on with its limbs.
+    BigInt operator-() && {
+        if (!isZero()) sign = -sign;
+        return std::move(*this);
+    }
 
     // Note: sign ignored.
     void __internal_add(const BigInt& v) {
         if (a.size() < v.a.size()) {
             a.resize(v.a.size(), 0);
         }
-        for (int i = 0, carry = 0; i < (int) max(a.size(), v.a.size()) || carry; ++i) {
+        int carry = limbs_add(a.data(), v.a.data(), (int) v.a.size(), 0);
+        for (int i = (int) v.a.size(); carry; ++i) {
             if (i == (int) a.size()) a.push_back(0);
 
-            a[i] += carry + (i < (int) v.a.size() ? v.a[i] : 0);
+            a[i] += carry;
             carry = a[i] >= BASE;
             if (carry) a[i] -= BASE;
         }
@@ -159,38 +1061,48 @@ struct BigInt {
 
     // Note: sign ignored.
     void __internal_sub(const BigInt& v) {
-        for (int i = 0, carry = 0; i < (int) v.a.size() || carry; ++i) {
-            a[i] -= carry + (i < (int) v.a.size() ? v.a[i] : 0);
+        int carry = limbs_sub(a.data(), v.a.data(), (int) v.a.size(), 0);
+        for (int i = (int) v.a.size(); carry; ++i) {
+            a[i] -= carry;
             carry = a[i] < 0;
             if (carry) a[i] += BASE;
         }
         this->trim();
     }
 
-    BigInt operator += (const BigInt& v) {
+    // |*this| = |v| - |*this| for |v| > |*this|, in place.
+    // Note: sign ignored.
+    void __internal_rsub(const BigInt& v) {
+        a.resize(v.a.size(), 0);
+        for (int i = 0, borrow = 0; i < (int) a.size(); ++i) {
+            a[i] = v.a[i] - a[i] - borrow;
+            borrow = a[i] < 0;
+            if (borrow) a[i] += BASE;
+        }
+        this->trim();
+    }
+
+    BigInt& operator += (const BigInt& v) {
         if (sign == v.sign) {
             __internal_add(v);
         } else {
             if (__compare_abs(*this, v) >= 0) {
                 __internal_sub(v);
             } else {
-                BigInt vv = v;
-                swap(*this, vv);
-                __internal_sub(vv);
+                __internal_rsub(v);
+                this->sign = v.sign;
             }
         }
         return *this;
     }
 
-    BigInt operator -= (const BigInt& v) {
+    BigInt& operator -= (const BigInt& v) {
         if (sign == v.sign) {
             if (__compare_abs(*this, v) >= 0) {
                 __internal_sub(v);
             } else {
-                BigInt vv = v;
-                swap(*this, vv);
-                __internal_sub(vv);
-                this->sign = -this->sign;
+                __internal_rsub(v);
+                this->sign = -v.sign;
             }
         } else {
             __internal_add(v);
@@ -224,20 +1136,66 @@ struct BigInt {
     template< typename L, typename R >
         typename std::enable_if<
             std::is_convertible<L, BigInt>::value &&
-            std::is_convertible<R, BigInt>::value,
+            std::is_convertible<R, BigInt>::value &&
+            (std::is_lvalue_reference<R&&>::value || !std::is_same<typename std::decay<L>::type, BigInt>::value || std::is_rvalue_reference<L&&>::value),
             BigInt>::type friend operator - (L&& l, R&& r) {
         BigInt result(std::forward<L>(l));
         result -= r;
         return result;
     }
+    // l - r = -(r - l), which reuses the temporary on the right.
+    template< typename L, typename R >
+        typename std::enable_if<
+            std::is_same<typename std::decay<L>::type, BigInt>::value &&
+            std::is_lvalue_reference<L&&>::value &&
+            std::is_convertible<R, BigInt>::value &&
+            std::is_rvalue_reference<R&&>::value,
+            BigInt>::type friend operator - (L&& l, R&& r) {
+        BigInt result(std::move(r));
+        result -= l;
+        return -std::move(result);
+    }
 
-    // -------------------- Operators * / % --------------------
-    friend pair<BigInt, BigInt> divmod(const BigInt& a1, const BigInt& b1) {
-        // assert(b1 > 0);  // divmod not well-defined for b < 0.
+    // The same for * when one side is a temporary and the other fits in a
+    // limb: the temporary is scaled in place.  Otherwise the product needs
+    // fresh limbs anyway.
+    friend BigInt operator*(BigInt&& l, const BigInt& r) {
+        if (&l != &r && r.a.size() == 1) {
+            l *= r;
+            return std::move(l);
+        }
+        return static_cast<const BigInt&>(l) * r;
+    }
+    friend BigInt operator*(const BigInt& l, BigInt&& r) {
+        return std::move(r) * l;
+    }
+    // Both temporaries: the longer one is scaled when the other is a limb.
+    friend BigInt operator*(BigInt&& l, BigInt&& r) {
+        if (l.a.size() < r.a.size()) return std::move(r) * static_cast<const BigInt&>(l);
+        return std::move(l) * static_cast<const BigInt&>(r);
+    }
+    // A temporary dividend is divided in its own limbs, see operator/= and
+    // divide_knuth; only the Newton tier builds fresh ones.
+    friend BigInt operator/(BigInt&& l, const BigInt& r) {
+        l /= r;
+        return std::move(l);
+    }
+    friend BigInt operator%(BigInt&& l, const BigInt& r) {
+        if (&l == &r || r.a.size() == 1 || newton_division(l, r))
+            return static_cast<const BigInt&>(l) % r;
+        divide_knuth(l, r, true);
+        l.trim();
+        if (l < 0) l += r;
+        return std::move(l);
+    }
 
+    // -------------------- Operators * / % --------------------
+    // Schoolbook division of non-negative a1 by positive b1, kept as the
+    // reference for divmod_knuth.
+    static pair<BigInt, BigInt> divmod_simple(const BigInt& a1, const BigInt& b1) {
         long long norm = BASE / (b1.a.back() + 1);
-        BigInt a = a1.abs() * norm;
-        BigInt b = b1.abs() * norm;
+        BigInt a = a1 * norm;
+        BigInt b = b1 * norm;
         BigInt q = 0, r = 0;
         q.a.resize(a.a.size());
 
@@ -254,19 +1212,273 @@ struct BigInt {
             q.a[i] = d;
         }
 
-        q.sign = a1.sign * b1.sign;
-        r.sign = a1.sign;
         q.trim();
         r.trim();
-        auto res = make_pair(q, r / norm);
+        return make_pair(q, r / norm);
+    }
+
+    // Knuth's Algorithm D (TAOCP 4.3.1) for non-negative a and positive b.
+    // Operands are normalized once so that the top divisor limb is at least
+    // BASE / 2; then each quotient limb estimated from the top two remainder
+    // limbs is at most two units too big.
+    static pair<BigInt, BigInt> divmod_knuth(const BigInt &a, const BigInt &b) {
+        int m = b.a.size();
+        if (m == 1) return divmod_limb(a, LimbDivisor(b.a[0]));
+
+        LimbVector v;
+        int norm = normalize_divisor(b, v);
+        return divmod_normalized(a, v, norm, LimbDivisor(v[m - 1]));
+    }
+
+    // v = |b| * norm with the top limb at least BASE / 2, returns norm.
+    static int normalize_divisor(const BigInt &b, LimbVector &v) {
+        int m = b.a.size(), norm = BASE / (b.a.back() + 1);
+        v.resize(m);
+        long long carry = 0;
+        for (int i = 0; i < m; ++i) {
+            long long cur = (long long) b.a[i] * norm + carry;
+            v[i] = (int) (cur % BASE);
+            carry = cur / BASE;
+        }
+        return norm;
+    }
+
+    // Algorithm D on the limbs of x itself: they become those of |x| / |b|,
+    // or of |x| % |b| when remainder is set, for b of at least two limbs.
+    // The sign of x is left to the caller.  Apart from the normalized copy
+    // of b, no limbs are allocated unless x has no room for one more.
+    static void divide_knuth(BigInt &x, const BigInt &b, bool remainder) {
+        int n = x.a.size(), m = b.a.size();
+        if (n < m) {
+            if (!remainder) x.a.clear();
+            return;
+        }
+        LimbVector v;
+        int norm = normalize_divisor(b, v);
+        divide_normalized(x.a, v, norm, LimbDivisor(v[m - 1]));
+        if (remainder) {
+            x.a.resize(m);
+        } else {
+            int *u = x.a.data();
+            copy(u + m, u + n + 1, u);
+            x.a.resize(n - m + 1);
+        }
+    }
+
+    // Non-negative a by the one-limb divisor d.
+    static pair<BigInt, BigInt> divmod_limb(const BigInt &a, const LimbDivisor &d) {
+        int n = a.a.size();
+        BigInt q;
+        q.a.resize(n);
+        int *pq = q.a.data();
+        long long rem = 0;
+        for (int i = n - 1; i >= 0; --i) {
+            long long qi;
+            d.divide(a.a[i] + rem * BASE, qi, rem);
+            pq[i] = (int) qi;
+        }
+        q.trim();
+        return make_pair(q, BigInt(rem));
+    }
+
+    // Non-negative a by the divisor v = b * norm of m >= 2 limbs, top
+    // divides by its top limb.
+    static pair<BigInt, BigInt> divmod_normalized(const BigInt &a, const LimbVector &v, int norm,
+                                                  const LimbDivisor &top) {
+        int n = a.a.size(), m = v.size();
+        if (n < m) return make_pair(BigInt(0), a);
+
+        BigInt q, r;
+        r.a.reserve(n + 1);
+        r.a.assign(a.a.begin(), a.a.end());
+        divide_normalized(r.a, v, norm, top);
+        q.a.assign(r.a.begin() + m, r.a.end());
+        r.a.resize(m);
+        q.trim();
+        r.trim();
+        return make_pair(q, r);
+    }
+
+    // The loop of Algorithm D in place.  u holds the n >= m limbs of the
+    // dividend and grows by one; on return u[0 .. m) is the remainder and
+    // u[m .. n] the quotient.  Each step leaves the top limb of its window
+    // zero, which is where its quotient limb goes.
+    static void divide_normalized(LimbVector &u_limbs, const LimbVector &v, int norm,
+                                  const LimbDivisor &top) {
+        int n = u_limbs.size(), m = v.size();
+        u_limbs.resize(n + 1);
+        int *u = u_limbs.data();
+        u[n] = limbs_mul_small(u, n, norm, 0);
+
+        long long v1 = v[m - 1], v2 = v[m - 2];
+        for (int j = n - m; j >= 0; --j) {
+            long long qhat, rhat;
+            top.divide((long long) u[j + m] * BASE + u[j + m - 1], qhat, rhat);
+            while (qhat >= BASE || qhat * v2 > rhat * BASE + u[j + m - 2]) {
+                --qhat;
+                rhat += v1;
+                if (rhat >= BASE) break;
+            }
+
+            // u[j .. j + m] -= qhat * v
+            long long borrow = 0, carry = 0;
+            for (int i = 0; i < m; ++i) {
+                long long p = qhat * v[i] + carry;
+                carry = p / BASE;
+                long long t = u[i + j] - p % BASE - borrow;
+                borrow = t < 0;
+                u[i + j] = (int) (borrow ? t + BASE : t);
+            }
+            long long t = u[j + m] - carry - borrow;
+            u[j + m] = (int) t;
+
+            // Rare case: qhat was still one too big, add the divisor back.
+            if (t < 0) {
+                --qhat;
+                int c = 0;
+                for (int i = 0; i < m; ++i) {
+                    u[i + j] += v[i] + c;
+                    c = u[i + j] >= BASE;
+                    if (c) u[i + j] -= BASE;
+                }
+                u[j + m] += c;
+            }
+            u[j + m] = (int) qhat;
+        }
+
+        long long rem = 0;
+        for (int i = m - 1; i >= 0; --i) {
+            long long cur = u[i] + rem * BASE;
+            u[i] = (int) (cur / norm);
+            rem = cur % norm;
+        }
+    }
+
+    // -------------------- Newton division --------------------
+    // Divisors and quotients of at least this many limbs are divided through
+    // a Newton reciprocal, so division costs a few multiplications.
+    static const int NEWTON_THRESHOLD = 1024;
+
+    // *this * BASE^k for k >= 0, *this / BASE^-k (truncated) for k < 0.
+    BigInt shift_limbs(int k) const {
+        BigInt res;
+        res.sign = sign;
+        if (k >= 0) {
+            if (a.empty()) return res;
+            res.a.resize(a.size() + k);
+            copy(a.begin(), a.end(), res.a.begin() + k);
+        } else if (-k < (int) a.size()) {
+            res.a.assign(a.begin() - k, a.end());
+        }
+        res.trim();
+        return res;
+    }
+
+    // BASE^2m / y for positive y of m limbs, off by at most a few units.
+    static BigInt reciprocal(const BigInt &y) {
+        int m = y.a.size();
+        if (m <= NEWTON_THRESHOLD)
+            return divmod_knuth(BigInt(1).shift_limbs(2 * m), y).first;
+
+        // xh ~ BASE^2h / yh for the top h limbs yh of y is good to about h - 1
+        // limbs; one Newton step x += x * (BASE^2m - y * x) / BASE^2m with
+        // x = xh * BASE^(m - h) doubles that to the whole m + 1 limbs.
+        int h = m / 2 + 2;
+        BigInt xh = reciprocal(y.shift_limbs(h - m));
+        BigInt e = BigInt(1).shift_limbs(m + h) - y * xh;
+        return xh.shift_limbs(m - h) + (xh * e).shift_limbs(-2 * h);
+    }
+
+    // Division of non-negative a by positive b through the reciprocal of b.
+    static pair<BigInt, BigInt> divmod_newton(const BigInt &a, const BigInt &b) {
+        int n = a.a.size(), m = b.a.size();
+        if (n < m) return make_pair(BigInt(0), a);
+
+        // Short quotient: the top n - m + 2 limbs of the divisor determine it
+        // up to a couple of units.
+        int s = m - (n - m + 2);
+        if (s > 0) {
+            BigInt q = divmod_unsigned(a.shift_limbs(-s), b.shift_limbs(-s)).first;
+            BigInt r = a - q * b;
+            while (r < 0) {
+                r += b, q -= 1;
+            }
+            while (r >= b) {
+                r -= b, q += 1;
+            }
+            return make_pair(q, r);
+        }
+
+        return divmod_reciprocal(a, b, reciprocal(b));
+    }
+
+    // Long quotient: schoolbook division in base BASE^m, every 2m-by-m step
+    // is one multiplication by x = reciprocal(b) plus a correction.
+    static pair<BigInt, BigInt> divmod_reciprocal(const BigInt &a, const BigInt &b,
+                                                  const BigInt &x) {
+        int n = a.a.size(), m = b.a.size();
+        if (n < m) return make_pair(BigInt(0), a);
+
+        BigInt q, r;
+        q.a.resize(n);
+        for (int i = (n - 1) / m * m; i >= 0; i -= m) {
+            BigInt cur;
+            cur.a.assign(a.a.begin() + i, a.a.begin() + min(i + m, n));
+            cur.trim();
+            cur += r.shift_limbs(m);
+            BigInt d = (cur.shift_limbs(1 - m) * x).shift_limbs(-m - 1);
+            r = cur - d * b;
+            while (r < 0) {
+                r += b, d -= 1;
+            }
+            while (r >= b) {
+                r -= b, d += 1;
+            }
+            copy(d.a.begin(), d.a.end(), q.a.begin() + i);
+        }
+        q.trim();
+        return make_pair(q, r);
+    }
+
+    // Whether a / b goes through the Newton reciprocal rather than Knuth.
+    static bool newton_division(const BigInt &a, const BigInt &b) {
+        return (int) b.a.size() >= NEWTON_THRESHOLD &&
+               (int) (a.a.size() - b.a.size()) >= NEWTON_THRESHOLD;
+    }
+
+    // Division of non-negative a by positive b.
+    static pair<BigInt, BigInt> divmod_unsigned(const BigInt &a, const BigInt &b) {
+        if (newton_division(a, b)) return divmod_newton(a, b);
+        return divmod_knuth(a, b);
+    }
+
+    friend pair<BigInt, BigInt> divmod(const BigInt& a1, const BigInt& b1) {
+        // assert(b1 > 0);  // divmod not well-defined for b < 0.
+
+        auto res = divmod_unsigned(a1.abs(), b1.abs());
+        res.first.sign = a1.sign * b1.sign;
+        res.second.sign = a1.sign;
+        res.first.trim();
+        res.second.trim();
         if (res.second < 0) res.second += b1;
         return res;
     }
     BigInt operator/(const BigInt &v) const {
+        if (v.a.size() == 1) {
+            BigInt res = *this;
+            res /= v;
+            return res;
+        }
         return divmod(*this, v).first;
     }
 
+    // A one-limb divisor leaves a remainder of one limb, no divmod needed.
     BigInt operator%(const BigInt &v) const {
+        if (v.a.size() == 1) {
+            BigInt res = *this % (long long) v.a[0];
+            if (res < 0) res += v;
+            return res;
+        }
         return divmod(*this, v).second;
     }
 
@@ -286,7 +1498,7 @@ struct BigInt {
         trim();
     }
 
-    BigInt operator/(int v) const {
+    BigInt operator/(int v) const & {
         assert(v > 0);  // operator / not well-defined for v <= 0.
 
         if (llabs(v) >= BASE) {
@@ -296,8 +1508,25 @@ struct BigInt {
         res /= v;
         return res;
     }
+    BigInt operator/(int v) && {
+        assert(v > 0);  // operator / not well-defined for v <= 0.
+        *this /= v;
+        return std::move(*this);
+    }
     void operator/=(const BigInt &v) {
-        *this = *this / v;
+        if (v.a.size() == 1) {
+            *this /= v.a[0];
+            sign *= v.sign;
+            trim();
+            return;
+        }
+        if (this == &v || newton_division(*this, v)) {
+            *this = *this / v;
+            return;
+        }
+        divide_knuth(*this, v, false);
+        sign *= v.sign;
+        trim();
     }
 
     long long operator%(long long v) const {
@@ -316,31 +1545,13 @@ struct BigInt {
         }
         if (v < 0)
             sign = -sign, v = -v;
-        for (int i = 0, carry = 0; i < (int) a.size() || carry; ++i) {
-            if (i == (int) a.size())
-                a.push_back(0);
-            long long cur = a[i] * (long long) v + carry;
-            carry = (int) (cur / BASE);
-            a[i] = (int) (cur % BASE);
-            //asm("divl %%ecx" : "=a"(carry), "=d"(a[i]) : "A"(cur), "c"(base));
-            /*
-             int val;
-             __asm {
-             lea esi, cur
-             mov eax, [esi]
-             mov edx, [esi+4]
-             mov ecx, base
-             div ecx
-             mov carry, eax
-             mov val, edx;
-             }
-             a[i] = val;
-             */
-        }
+        int carry = limbs_mul_small(a.data(), (int) a.size(), v, 0);
+        if (carry)
+            a.push_back(carry);
         trim();
     }
 
-    BigInt operator*(int v) const {
+    BigInt operator*(int v) const & {
         if (llabs(v) >= BASE) {
             return *this * BigInt(v);
         }
@@ -348,14 +1559,20 @@ struct BigInt {
         res *= v;
         return res;
     }
+    BigInt operator*(int v) && {
+        *this *= v;
+        return std::move(*this);
+    }
 
     // Convert BASE 10^old --> 10^new.
-    static vector<int> convert_base(const vector<int> &a, int old_digits, int new_digits) {
+    template <typename Limbs>
+    static vector<int> convert_base(const Limbs &a, int old_digits, int new_digits) {
         vector<long long> p(max(old_digits, new_digits) + 1);
         p[0] = 1;
         for (int i = 1; i < (int) p.size(); i++)
             p[i] = p[i - 1] * 10;
         vector<int> res;
+        res.reserve(a.size() * old_digits / new_digits + 1);
         long long cur = 0;
         int cur_digits = 0;
         for (int i = 0; i < (int) a.size(); i++) {
@@ -373,186 +1590,805 @@ struct BigInt {
         return res;
     }
 
-    void fft(vector<complex<double> > & a, bool invert) const {
-        int n = (int) a.size();
+    // -------------------- Threads --------------------
+    // Worker threads for one long multiplication, 1 keeps everything on the
+    // calling thread.  Work is only ever split into independent pieces, so
+    // the product does not depend on the setting.
+    static int &mul_threads() {
+        static int threads = 1;
+        return threads;
+    }
 
-        for (int i = 1, j = 0; i < n; ++i) {
-            int bit = n >> 1;
-            for (; j >= bit; bit >>= 1)
-                j -= bit;
-            j += bit;
-            if (i < j)
-                swap(a[i], a[j]);
-        }
-
-        for (int len = 2; len <= n; len <<= 1) {
-            double ang = 2 * 3.14159265358979323846 / len * (invert ? -1 : 1);
-            complex<double> wlen(cos(ang), sin(ang));
-            for (int i = 0; i < n; i += len) {
-                complex<double> w(1);
-                for (int j = 0; j < len / 2; ++j) {
-                    complex<double> u = a[i + j];
-                    complex<double> v = a[i + j + len / 2] * w;
-                    a[i + j] = u + v;
-                    a[i + j + len / 2] = u - v;
-                    w *= wlen;
-                }
+    // Roots of unity laid out as Transforms::ntt_twiddles; each stage takes
+    // every second root of the next one, so all twiddles are computed
+    // directly from cos and sin, none accumulated.
+    static shared_ptr<const vector<complex<double> > > fft_twiddles(int log) {
+        static TransformTableCache<complex<double> > cache;
+        return cache.get(log, [](int n) {
+            vector<complex<double> > w(max(n, 2));
+            for (int j = 0; j < n / 2; ++j) {
+                double ang = 2 * 3.14159265358979323846 * j / n;
+                w[n / 2 + j] = complex<double>(cos(ang), sin(ang));
             }
-        }
-        if (invert)
+            for (int i = n / 2 - 1; i >= 1; --i)
+                w[i] = w[2 * i];
+            return w;
+        });
+    }
+
+    void fft(vector<complex<double> > & a, bool invert, int threads = 1) const {
+        int n = (int) a.size();
+        Transforms::bit_reverse(a.data(), n);
+        shared_ptr<const vector<complex<double> > > twiddles =
+            fft_twiddles(Transforms::log2_ceil(n));
+        Transforms::butterfly_stages(a.data(), n, twiddles->data(), threads,
+                         [](complex<double> &x, complex<double> &y, const complex<double> &w) {
+                             complex<double> u = x, v = y * w;
+                             x = u + v;
+                             y = u - v;
+                         });
+        // The inverse transform is the forward one read backwards.
+        if (invert) {
+            reverse(a.begin() + 1, a.end());
             for (int i = 0; i < n; ++i)
                 a[i] /= n;
+        }
     }
 
+    // Both operands go into one complex sequence, a in the real parts and b
+    // in the imaginary ones: (a + ib)^2 = a^2 - b^2 + 2i ab, so one forward
+    // and one inverse transform give the product.  A square is just a^2.
     void multiply_fft(const vector<int> &a, const vector<int> &b, vector<int> &res) const {
-        vector<complex<double> > fa(a.begin(), a.end());
-        vector<complex<double> > fb(b.begin(), b.end());
+        bool square = &a == &b;
         int n = 1;
         while (n < (int) max(a.size(), b.size()))
             n <<= 1;
         n <<= 1;
-        fa.resize(n);
-        fb.resize(n);
+        vector<complex<double> > fa(n);
+        for (int i = 0; i < (int) a.size(); ++i)
+            fa[i].real(a[i]);
+        if (!square)
+            for (int i = 0; i < (int) b.size(); ++i)
+                fa[i].imag(b[i]);
 
-        fft(fa, false);
-        fft(fb, false);
+        int threads = mul_threads();
+        fft(fa, false, threads);
         for (int i = 0; i < n; ++i)
-            fa[i] *= fb[i];
-        fft(fa, true);
+            fa[i] *= fa[i];
+        fft(fa, true, threads);
 
         res.resize(n);
         long long carry = 0;
         for (int i = 0; i < n; ++i) {
-            long long t = (long long) (fa[i].real() + 0.5) + carry;
+            double x = square ? fa[i].real() : fa[i].imag() / 2;
+            long long t = (long long) (x + 0.5) + carry;
             carry = t / 1000;
             res[i] = t % 1000;
         }
     }
 
+    // -------------------- Number-theoretic transform --------------------
+    // res[0 .. na + nb) = a * b through Transforms' three-prime convolution
+    // of the limbs themselves.  Each coefficient of the product is below
+    // min(na, nb) * BASE^2 < P1 * P2 * P3, so it is exact for
+    // na + nb - 1 <= 2^MAX_LOG.
+    static void multiply_ntt(const int *a, int na, const int *b, int nb, int *res,
+                             int threads = 1) {
+        const unsigned long long P1 = Transforms::P1, P2 = Transforms::P2;
+        int n = 1;
+        while (n < na + nb - 1)
+            n <<= 1;
+        vector<unsigned> f1, f2, f3;
+        Transforms::convolve_three(a, na, b, nb, n, f1, f2, f3, threads);
+
+        // x = v1 + P1 * (v2 + P2 * v3), split as c0 + c1 * BASE.
+        unsigned long long carry = 0;
+        for (int i = 0; i < na + nb; ++i) {
+            unsigned long long c0 = 0, c1 = 0;
+            if (i < na + nb - 1) {
+                unsigned long long v2, v3;
+                Transforms::garner(f1[i], f2[i], f3[i], v2, v3);
+                unsigned long long t = v2 + P2 * v3;
+                c0 = f1[i] + P1 * (t % BASE);
+                c1 = P1 * (t / BASE);
+            }
+            unsigned long long cur = c0 + carry;
+            res[i] = (int) (cur % BASE);
+            carry = cur / BASE + c1;
+        }
+    }
+
+    // res[0 .. nr) += x[0 .. nx), the sum must fit into nr limbs.
+    static void add_limbs(int *res, int nr, const int *x, int nx) {
+        int n = min(nr, nx);
+        int carry = limbs_add(res, x, n, 0);
+        for (int i = n; i < nr && carry; ++i) {
+            carry = ++res[i] == BASE;
+            if (carry) res[i] = 0;
+        }
+    }
+
+    BigInt mul_ntt(const BigInt &v) const {
+        BigInt res;
+        if (a.empty() || v.a.empty()) return res;
+        res.sign = sign * v.sign;
+        int na = a.size(), nb = v.a.size();
+        res.a.assign(na + nb, 0);
+        if (na + nb - 1 <= (1 << Transforms::MAX_LOG)) {
+            multiply_ntt(a.data(), na, v.a.data(), nb, res.a.data(), mul_threads());
+        } else {
+            // Too long for one transform: multiply block by block.
+            const int chunk = 1 << (Transforms::MAX_LOG - 1);
+            vector<int> part(2 * chunk);
+            for (int i = 0; i < na; i += chunk)
+                for (int j = 0; j < nb; j += chunk) {
+                    int ni = min(chunk, na - i), nj = min(chunk, nb - j);
+                    multiply_ntt(a.data() + i, ni, v.a.data() + j, nj, part.data(),
+                                 mul_threads());
+                    add_limbs(res.a.data() + i + j, na + nb - i - j, part.data(), ni + nj);
+                }
+        }
+        res.trim();
+        return res;
+    }
+
     BigInt mul_simple(const BigInt &v) const {
+        if (&v == this) return sqr_simple();
         BigInt res;
         res.sign = sign * v.sign;
         res.a.resize(a.size() + v.a.size());
+        int *r = res.a.data();
         for (int i = 0; i < (int) a.size(); ++i)
             if (a[i])
                 for (int j = 0, carry = 0; j < (int) v.a.size() || carry; ++j) {
-                    long long cur = res.a[i + j] + (long long) a[i] * (j < (int) v.a.size() ? v.a[j] : 0) + carry;
+                    long long cur = r[i + j] + (long long) a[i] * (j < (int) v.a.size() ? v.a[j] : 0) + carry;
+                    carry = (int) (cur / BASE);
+                    r[i + j] = (int) (cur % BASE);
+                }
+        res.trim();
+        return res;
+    }
+
+    // Schoolbook square: every cross product a[i] * a[j], i < j, once, then
+    // the sum doubled and the squares on the diagonal added.
+    BigInt sqr_simple() const {
+        BigInt res;
+        int n = a.size();
+        res.sign = 1;
+        res.a.resize(2 * n);
+        int *r = res.a.data();
+        for (int i = 0; i < n; ++i)
+            if (a[i])
+                for (int j = i + 1, carry = 0; j < n || carry; ++j) {
+                    long long cur = r[i + j] + (long long) a[i] * (j < n ? a[j] : 0) + carry;
                     carry = (int) (cur / BASE);
-                    res.a[i + j] = (int) (cur % BASE);
+                    r[i + j] = (int) (cur % BASE);
                 }
+        long long carry = 0;
+        for (int i = 0; i < 2 * n; ++i) {
+            long long cur = 2LL * r[i] + carry;
+            if (i % 2 == 0) cur += (long long) a[i / 2] * a[i / 2];
+            carry = cur / BASE;
+            r[i] = (int) (cur % BASE);
+        }
         res.trim();
         return res;
     }
 
     typedef vector<long long> vll;
 
-    static vll karatsubaMultiply(const vll &a, const vll &b) {
-        int n = a.size();
-        vll res(n + n);
+    // res[0, 2n) = a[0, n) * b[0, n), n is a power of two.  scratch must hold
+    // 4n values: each level keeps the two half sums and their product there
+    // and hands the rest down, so the recursion never allocates.  With
+    // several threads the top levels fork the three products as tasks, each
+    // of the two forked ones with a workspace of its own.
+    static void karatsubaMultiply(const long long *a, const long long *b, int n,
+                                  long long *res, long long *scratch, int threads = 1) {
         if (n <= 32) {
+            fill(res, res + n + n, 0LL);
             for (int i = 0; i < n; i++)
                 for (int j = 0; j < n; j++)
                     res[i + j] += a[i] * b[j];
-            return res;
+            return;
         }
 
         int k = n >> 1;
-        vll a1(a.begin(), a.begin() + k);
-        vll a2(a.begin() + k, a.end());
-        vll b1(b.begin(), b.begin() + k);
-        vll b2(b.begin() + k, b.end());
-
-        vll a1b1 = karatsubaMultiply(a1, b1);
-        vll a2b2 = karatsubaMultiply(a2, b2);
-
-        for (int i = 0; i < k; i++)
-            a2[i] += a1[i];
-        for (int i = 0; i < k; i++)
-            b2[i] += b1[i];
-
-        vll r = karatsubaMultiply(a2, b2);
-        for (int i = 0; i < (int) a1b1.size(); i++)
-            r[i] -= a1b1[i];
-        for (int i = 0; i < (int) a2b2.size(); i++)
-            r[i] -= a2b2[i];
-
-        for (int i = 0; i < (int) r.size(); i++)
+        long long *a12 = scratch, *b12 = scratch + k, *r = scratch + n;
+        auto half_sums = [=] {
+            for (int i = 0; i < k; i++)
+                a12[i] = a[i] + a[i + k];
+            for (int i = 0; i < k; i++)
+                b12[i] = b[i] + b[i + k];
+        };
+
+        // a1b1 and a2b2 land right where they belong in res.
+        if (threads > 1 && n >= 2048) {
+            int share = max(1, threads / 3);
+            vll s1(2 * n), s2(2 * n);
+            half_sums();
+            thread t1([=, &s1] { karatsubaMultiply(a, b, k, res, s1.data(), share); });
+            thread t2([=, &s2] {
+                karatsubaMultiply(a + k, b + k, k, res + n, s2.data(), share);
+            });
+            karatsubaMultiply(a12, b12, k, r, scratch + 2 * n,
+                              max(1, threads - 2 * share));
+            t1.join();
+            t2.join();
+        } else {
+            // The outer products borrow the scratch, the sums go in after.
+            karatsubaMultiply(a, b, k, res, scratch);
+            karatsubaMultiply(a + k, b + k, k, res + n, scratch);
+            half_sums();
+            karatsubaMultiply(a12, b12, k, r, scratch + 2 * n);
+        }
+        for (int i = 0; i < n; i++)
+            r[i] -= res[i] + res[i + n];
+
+        for (int i = 0; i < n; i++)
+            res[i + k] += r[i];
+    }
+
+    // Same for res[0, 2n) = a[0, n)^2: three half-size squares, forked the
+    // same way with several threads.
+    static void karatsubaSquare(const long long *a, int n, long long *res,
+                                long long *scratch, int threads = 1) {
+        if (n <= 32) {
+            fill(res, res + n + n, 0LL);
+            for (int i = 0; i < n; i++) {
+                res[i + i] += a[i] * a[i];
+                for (int j = i + 1; j < n; j++)
+                    res[i + j] += 2 * a[i] * a[j];
+            }
+            return;
+        }
+
+        int k = n >> 1;
+        long long *a12 = scratch, *r = scratch + n;
+        auto half_sum = [=] {
+            for (int i = 0; i < k; i++)
+                a12[i] = a[i] + a[i + k];
+        };
+
+        if (threads > 1 && n >= 2048) {
+            int share = max(1, threads / 3);
+            vll s1(2 * n), s2(2 * n);
+            half_sum();
+            thread t1([=, &s1] { karatsubaSquare(a, k, res, s1.data(), share); });
+            thread t2([=, &s2] { karatsubaSquare(a + k, k, res + n, s2.data(), share); });
+            karatsubaSquare(a12, k, r, scratch + 2 * n, max(1, threads - 2 * share));
+            t1.join();
+            t2.join();
+        } else {
+            karatsubaSquare(a, k, res, scratch);
+            karatsubaSquare(a + k, k, res + n, scratch);
+            half_sum();
+            karatsubaSquare(a12, k, r, scratch + 2 * n);
+        }
+        for (int i = 0; i < n; i++)
+            r[i] -= res[i] + res[i + n];
+
+        for (int i = 0; i < n; i++)
             res[i + k] += r[i];
-        for (int i = 0; i < (int) a1b1.size(); i++)
-            res[i] += a1b1[i];
-        for (int i = 0; i < (int) a2b2.size(); i++)
-            res[i + n] += a2b2[i];
-        return res;
     }
 
     BigInt mul_karatsuba(const BigInt &v) const {
         vector<int> a6 = convert_base(this->a, BASE_DIGITS, 6);
-        vector<int> b6 = convert_base(v.a, BASE_DIGITS, 6);
-        vll a(a6.begin(), a6.end());
-        vll b(b6.begin(), b6.end());
-        while (a.size() < b.size())
-            a.push_back(0);
-        while (b.size() < a.size())
-            b.push_back(0);
-        while (a.size() & (a.size() - 1))
-            a.push_back(0), b.push_back(0);
-        vll c = karatsubaMultiply(a, b);
-        BigInt res;
-        res.sign = sign * v.sign;
+        vector<int> b6 = &v == this ? vector<int>() : convert_base(v.a, BASE_DIGITS, 6);
+        int n = 1;
+        while (n < (int) max(a6.size(), b6.size()))
+            n <<= 1;
+        // Operands, product and the workspace for the whole recursion at once.
+        vll buf(8 * n);
+        long long *a = buf.data(), *b = a + n, *c = b + n, *scratch = c + 2 * n;
+        copy(a6.begin(), a6.end(), a);
+        copy(b6.begin(), b6.end(), b);
+        int threads = mul_threads();
+        if (&v == this)
+            karatsubaSquare(a, n, c, scratch, threads);
+        else
+            karatsubaMultiply(a, b, n, c, scratch, threads);
+        vector<int> res6(2 * n);
         long long carry = 0;
-        for (int i = 0; i < (int) c.size(); i++) {
+        for (int i = 0; i < 2 * n; i++) {
             long long cur = c[i] + carry;
-            res.a.push_back((int) (cur % 1000000));
+            res6[i] = (int) (cur % 1000000);
             carry = cur / 1000000;
         }
-        res.a = convert_base(res.a, 6, BASE_DIGITS);
+        BigInt res;
+        res.sign = sign * v.sign;
+        res.a = convert_base(res6, 6, BASE_DIGITS);
         res.trim();
         return res;
     }
 
+    // -------------------- Toom-Cook --------------------
+    // Toom-k: split both operands into k pieces of p limbs, multiply the
+    // piece polynomials at 2k - 1 points (0, 1, -1, 2, -2, 3 and infinity)
+    // and interpolate.  Interpolation goes through Newton divided differences,
+    // which stay integral for integer polynomials, so every division by a
+    // difference of points (at most 5) is exact.  The coefficients of the
+    // product are sums of products of pieces, never negative, and are added
+    // straight into the result limbs.
+    BigInt mul_toom(const BigInt &v, int k) const {
+        static const int points[] = {0, 1, -1, 2, -2, 3};
+        int p = (max(a.size(), v.a.size()) + k - 1) / k;
+        // A shorter operand that does not reach the top piece would pay for
+        // full-length products at every point: cut the longer one instead.
+        if ((int) min(a.size(), v.a.size()) <= (k - 1) * p) return mul_unbalanced(v);
+        bool square = &v == this;
+        int n = 2 * k - 2; // finite points
+
+        // The pieces once, then Horner at every point on two accumulators.
+        vector<BigInt> pa(k), pb(square ? 0 : k);
+        for (int i = 0; i < k; ++i) {
+            pa[i] = limb_slice(i * p, p);
+            if (!square) pb[i] = v.limb_slice(i * p, p);
+        }
+        vector<BigInt> w(n);
+        BigInt ea, eb;
+        for (int j = 0; j < n; ++j) {
+            ea = pa[k - 1];
+            for (int i = k - 2; i >= 0; --i) {
+                ea *= points[j];
+                ea += pa[i];
+            }
+            if (square) {
+                w[j] = ea * ea;
+                continue;
+            }
+            eb = pb[k - 1];
+            for (int i = k - 2; i >= 0; --i) {
+                eb *= points[j];
+                eb += pb[i];
+            }
+            w[j] = ea * eb;
+        }
+        BigInt top = square ? pa[k - 1] * pa[k - 1] : pa[k - 1] * pb[k - 1];
+
+        // Take the x^(2k - 2) term off, the rest has degree 2k - 3.
+        for (int j = 0; j < n; ++j) {
+            int power = 1;
+            for (int i = 0; i < n; ++i) power *= points[j];
+            if (power) w[j] -= top * power;
+        }
+        for (int j = 1; j < n; ++j)
+            for (int i = n - 1; i >= j; --i) {
+                w[i] -= w[i - 1];
+                int d = points[i] - points[i - j];
+                if (d < 0) w[i].sign = -w[i].sign, d = -d;
+                w[i] /= d;
+            }
+        // Newton form to coefficients: c = c * (x - x_j) + w_j.
+        vector<BigInt> c(n + 1);
+        c[0] = std::move(w[n - 1]);
+        for (int j = n - 2; j >= 0; --j) {
+            for (int i = n - 1 - j; i >= 1; --i) {
+                c[i] *= -points[j];
+                c[i] += c[i - 1];
+            }
+            c[0] *= -points[j];
+            c[0] += w[j];
+        }
+        c[n] = std::move(top);
+
+        BigInt res;
+        int len = a.size() + v.a.size();
+        res.a.resize(len);
+        for (int i = 0; i <= n; ++i)
+            if (!c[i].isZero()) {
+                assert(c[i].sign > 0);
+                add_limbs(res.a.data() + i * p, len - i * p, c[i].a.data(), c[i].a.size());
+            }
+        res.sign = sign * v.sign;
+        res.trim();
+        return res;
+    }
+
+    // |*this| limbs [from, from + len) as a number.
+    BigInt limb_slice(int from, int len) const {
+        BigInt res;
+        if (from < (int) a.size())
+            res.a.assign(a.begin() + from, a.begin() + min(from + len, (int) a.size()));
+        res.trim();
+        return res;
+    }
+
+    // -------------------- Choosing an algorithm --------------------
+    // Crossover points in limbs of the shorter operand, each algorithm is
+    // used from its threshold up to the next one, so they must not decrease
+    // (an equal pair leaves the lower tier empty).  Defaults come from
+    // bigint_tuning.h, regenerated for the host by 'make run_tune'.
+    static_assert(TUNED_KARATSUBA_THRESHOLD <= TUNED_TOOM3_THRESHOLD &&
+                      TUNED_TOOM3_THRESHOLD <= TUNED_TOOM4_THRESHOLD &&
+                      TUNED_TOOM4_THRESHOLD <= TUNED_NTT_THRESHOLD,
+                  "bigint_tuning.h: multiplication thresholds out of order");
+    struct MulThresholds {
+        int karatsuba = TUNED_KARATSUBA_THRESHOLD;
+        int toom3 = TUNED_TOOM3_THRESHOLD;
+        int toom4 = TUNED_TOOM4_THRESHOLD;
+        int ntt = TUNED_NTT_THRESHOLD;
+    };
+    static MulThresholds &thresholds() {
+        static MulThresholds t;
+        return t;
+    }
+
     void operator*=(const BigInt &v) {
+        if (&v != this && v.a.size() == 1) {
+            *this *= v.a[0];
+            sign *= v.sign;
+            trim();
+            return;
+        }
         *this = *this * v;
     }
+
+    // x * x is noticed by address: each tier below then squares, which
+    // saves a transform for NTT and roughly half the work for the others.
     BigInt operator*(const BigInt &v) const {
-        if (a.size() * v.a.size() <= 1000111) return mul_simple(v);
-        if (a.size() > 500111 || v.a.size() > 500111) return mul_fft(v);
-        return mul_karatsuba(v);
+        const MulThresholds &t = thresholds();
+        int n = min(a.size(), v.a.size());
+        // Karatsuba and Toom pad the shorter operand up to the longer one and
+        // NTT transforms both whole: far apart sizes go by chunks instead.
+        if (n >= t.karatsuba && (int) max(a.size(), v.a.size()) >= 2 * n)
+            return mul_unbalanced(v);
+        if (n >= t.ntt) return mul_ntt(v);
+        if (n >= t.toom4) return mul_toom(v, 4);
+        if (n >= t.toom3) return mul_toom(v, 3);
+        if (n >= t.karatsuba) return mul_karatsuba(v);
+        return mul_simple(v);
+    }
+
+    // Long times short: the long operand cut into chunks, every chunk times
+    // the short one added in place at its offset.  Chunks as long as the
+    // short operand make balanced products for the best tier below NTT;
+    // from NTT on a transform of 2^k >= 4m points takes 2^k - m + 1 limbs
+    // against the m of the short one, little padding and the short one's
+    // share spread thin.  Linear in the long operand for a fixed short one.
+    BigInt mul_unbalanced(const BigInt &v) const {
+        bool longer = a.size() >= v.a.size();
+        const BigInt &x = longer ? *this : v, &y = longer ? v : *this;
+        int n = x.a.size(), m = y.a.size(), len = m;
+        BigInt res;
+        res.sign = sign * v.sign;
+        if (!m) return res;
+        bool ntt = m >= thresholds().ntt;
+        if (ntt) {
+            int size = 1;
+            while (size < 4 * m)
+                size *= 2;
+            len = size - m + 1;
+        }
+        res.a.resize(n + m);
+        for (int i = 0; i < n; i += len) {
+            BigInt slice = x.limb_slice(i, len);
+            BigInt p = ntt ? slice.mul_ntt(y) : slice * y;
+            add_limbs(res.a.data() + i, n + m - i, p.a.data(), p.a.size());
+        }
+        res.trim();
+        return res;
     }
 
     BigInt mul_fft(const BigInt& v) const {
         BigInt res;
         res.sign = sign * v.sign;
-        multiply_fft(convert_base(a, BASE_DIGITS, 3), convert_base(v.a, BASE_DIGITS, 3), res.a);
-        res.a = convert_base(res.a, 3, BASE_DIGITS);
+        vector<int> c;
+        vector<int> a3 = convert_base(a, BASE_DIGITS, 3);
+        if (&v == this)
+            multiply_fft(a3, a3, c);
+        else
+            multiply_fft(a3, convert_base(v.a, BASE_DIGITS, 3), c);
+        res.a = convert_base(c, 3, BASE_DIGITS);
         res.trim();
         return res;
     }
 
-    // -------------------- Misc --------------------
-    BigInt abs() const {
-        BigInt res = *this;
-        res.sign *= res.sign;
+    // -------------------- GCD --------------------
+    // Operands of at least this many limbs are reduced by half-GCD steps.
+    static const int HGCD_THRESHOLD = 1500;
+
+    // Euclid with one divmod per quotient, kept as the reference for gcd.
+    static BigInt gcd_euclid(BigInt a, BigInt b) {
+        a.sign = b.sign = 1;
+        while (!b.isZero()) {
+            a = a % b;
+            swap(a, b);
+        }
+        return a;
+    }
+
+    // Binary GCD (Stein) on machine words, shifts and subtractions only.
+    static unsigned long long gcd_binary(unsigned long long a, unsigned long long b) {
+        if (!a || !b) return a | b;
+        int shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        while (b) {
+            b >>= __builtin_ctzll(b);
+            if (a > b) swap(a, b);
+            b -= a;
+        }
+        return a << shift;
+    }
+
+    // p * x + q * y for non-negative x, y and |p|, |q| <= BASE when the
+    // result is known to be non-negative: one pass, no temporaries.
+    static BigInt combine(const BigInt &x, long long p, const BigInt &y, long long q) {
+        int nx = x.a.size(), ny = y.a.size(), n = max(nx, ny);
+        BigInt res;
+        res.a.resize(n);
+        long long carry = 0;
+        for (int i = 0; i < n; ++i) {
+            long long cur = carry;
+            if (i < nx) cur += p * x.a[i];
+            if (i < ny) cur += q * y.a[i];
+            carry = cur / BASE;
+            cur %= BASE;
+            if (cur < 0) cur += BASE, --carry;
+            res.a[i] = (int) cur;
+        }
+        assert(carry >= 0);
+        for (; carry; carry /= BASE)
+            res.a.push_back((int) (carry % BASE));
+        res.trim();
         return res;
     }
-    void trim() {
-        while (!a.empty() && !a.back())
-            a.pop_back();
-        if (a.empty())
-            sign = 1;
+
+    // One batch of Lehmer's algorithm (TAOCP 4.5.2, Algorithm L) for
+    // a >= b > 0, a of at least two limbs: Euclid on the top two limbs of
+    // a and the same limbs of b while both bounds on each quotient agree and
+    // the cofactors stay within BASE.  Then a' = l0 a + l1 b, b' = l2 a + l3 b
+    // are the remainders that many steps further.  False if not even the
+    // first quotient is certain, then a division step has to do.
+    static bool lehmer_matrix(const BigInt &a, const BigInt &b, long long (&l)[4]) {
+        int n = a.a.size(), nb = b.a.size();
+        long long u = (long long) a.a[n - 1] * BASE + a.a[n - 2];
+        long long v = (nb >= n ? (long long) b.a[n - 1] * BASE : 0) + (nb >= n - 1 ? b.a[n - 2] : 0);
+        long long A = 1, B = 0, C = 0, D = 1;
+        while (v + C > 0 && v + D > 0) {
+            long long q = (u + A) / (v + C);
+            if (q != (u + B) / (v + D)) break;
+            long long c = max(llabs(C), llabs(D));
+            if (q > BASE / max(c, 1LL)) break;
+            long long nc = A - q * C, nd = B - q * D;
+            if (llabs(nc) > BASE || llabs(nd) > BASE) break;
+            A = C, C = nc;
+            B = D, D = nd;
+            long long t = u - q * v;
+            u = v, v = t;
+        }
+        l[0] = A, l[1] = B, l[2] = C, l[3] = D;
+        return B != 0;
     }
 
-    bool isZero() const {
-        return a.empty() || (a.size() == 1 && !a[0]);
+    // One Lehmer batch or, failing that, one division step on a > b > 0;
+    // with m: (a; b) = M (a'; b') is kept up to date for the caller's matrix
+    // M = (m[0] m[1]; m[2] m[3]) of determinant det.
+    static void gcd_step(BigInt &a, BigInt &b, BigInt *m, int &det) {
+        long long l[4];
+        if (a.a.size() >= 2 && lehmer_matrix(a, b, l)) {
+            BigInt x = combine(a, l[0], b, l[1]);
+            b = combine(a, l[2], b, l[3]);
+            a = std::move(x);
+            if (m) {
+                // M * L^-1, L^-1 = det L (l3 -l1; -l2 l0) is non-negative.
+                int d = l[0] * l[3] - l[1] * l[2] > 0 ? 1 : -1;
+                for (int i = 0; i < 4; i += 2) {
+                    BigInt m0 = combine(m[i], d * l[3], m[i + 1], -d * l[2]);
+                    m[i + 1] = combine(m[i], -d * l[1], m[i + 1], d * l[0]);
+                    m[i] = std::move(m0);
+                }
+                det *= d;
+            }
+        } else {
+            auto qr = divmod(a, b);
+            a = std::move(b);
+            b = std::move(qr.second);
+            if (m) {
+                // M * (q 1; 1 0)
+                for (int i = 0; i < 4; i += 2) {
+                    BigInt m0 = m[i] * qr.first + m[i + 1];
+                    m[i + 1] = std::move(m[i]);
+                    m[i] = std::move(m0);
+                }
+                det = -det;
+            }
+        }
+    }
+
+    // Half-GCD: Euclid steps on a > b > 0 of n limbs until b has at most
+    // s = n / 2 + 1 limbs, (a; b) = M (a'; b') with M = (m[0] m[1]; m[2] m[3])
+    // and det M = det.  The first half of the quotients comes from the top
+    // limbs: reduce a / BASE^p, b / BASE^p recursively and apply that to
+    // a, b, twice (after Moller, "On Schonhage's algorithm", 2008), so the
+    // work is a few multiplications per level; Lehmer batches finish up.
+    static void hgcd(BigInt &a, BigInt &b, BigInt (&m)[4], int &det) {
+        int n = a.a.size(), s = n / 2 + 1;
+        m[0] = m[3] = 1;
+        m[1] = m[2] = 0;
+        det = 1;
+        if ((int) b.a.size() <= s) return;
+        if (n >= HGCD_THRESHOLD) {
+            hgcd_top(a, b, n / 2, m, det);
+            if ((int) b.a.size() > s) gcd_step(a, b, m, det);
+            if ((int) b.a.size() > s) hgcd_top(a, b, max(2 * s - (int) a.a.size() + 1, 0), m, det);
+        }
+        while ((int) b.a.size() > s)
+            gcd_step(a, b, m, det);
     }
 
-    friend BigInt gcd(const BigInt &a, const BigInt &b) {
-        return b.isZero() ? a : gcd(b, a % b);
+    // One recursive half of hgcd: the reduction of the tops a / BASE^p and
+    // b / BASE^p, applied to a, b and multiplied into m.  Kept only when it
+    // gives a' > b' >= 0: then, its quotients being positive, they are
+    // exactly the first Euclid quotients of a / b.
+    static void hgcd_top(BigInt &a, BigInt &b, int p, BigInt (&m)[4], int &det) {
+        BigInt ah = a.shift_limbs(-p), bh = b.shift_limbs(-p), mh[4];
+        if (bh.isZero() || ah <= bh) return;
+        int dh;
+        hgcd(ah, bh, mh, dh);
+        if (mh[1].isZero() && mh[2].isZero()) return;
+
+        // (a'; b') = M^-1 (a; b), M^-1 = det (m3 -m1; -m2 m0).
+        BigInt x = mh[3] * a - mh[1] * b, y = mh[0] * b - mh[2] * a;
+        if (dh < 0) x = -std::move(x), y = -std::move(y);
+        if (!(y >= 0 && x > y)) return;
+        a = std::move(x);
+        b = std::move(y);
+        BigInt r[4];
+        for (int i = 0; i < 4; i += 2) {
+            r[i] = m[i] * mh[0] + m[i + 1] * mh[2];
+            r[i + 1] = m[i] * mh[1] + m[i + 1] * mh[3];
+        }
+        for (int i = 0; i < 4; ++i)
+            m[i] = std::move(r[i]);
+        det *= dh;
+    }
+
+    // Non-negative greatest common divisor: half-GCD while the operands are
+    // long and balanced, Lehmer batches below HGCD_THRESHOLD, binary GCD
+    // once both fit in a machine word.
+    friend BigInt gcd(const BigInt &a1, const BigInt &b1) {
+        BigInt a = a1.abs(), b = b1.abs();
+        if (a < b) swap(a, b);
+        int det;
+        while (!b.isZero()) {
+            if (a.a.size() <= 2)
+                return (long long) gcd_binary(a.word(), b.word());
+            if (b.a.size() == 1)
+                return (long long) gcd_binary(b.a[0], a % (long long) b.a[0]);
+            if ((int) a.a.size() >= HGCD_THRESHOLD && (int) b.a.size() > (int) a.a.size() / 2 + 1) {
+                BigInt m[4];
+                hgcd(a, b, m, det);
+            } else {
+                gcd_step(a, b, nullptr, det);
+            }
+        }
+        return a;
     }
     friend BigInt lcm(const BigInt &a, const BigInt &b) {
         return a / gcd(a, b) * b;
     }
 
-    friend BigInt sqrt(const BigInt &a1) {
+    // The value of a non-negative number of at most two limbs.
+    unsigned long long word() const {
+        unsigned long long res = 0;
+        for (int i = (int) a.size() - 1; i >= 0; --i)
+            res = res * BASE + a[i];
+        return res;
+    }
+
+    // -------------------- Roots --------------------
+    // floor(sqrt(a)) and a - floor(sqrt(a))^2 for a >= 0.  Newton's method
+    // with growing precision in the form of Zimmermann's recursive square
+    // root ("Karatsuba Square Root", 1999): the root s' of the top half is
+    // right in its top limbs and one step, a division of half the size,
+    // supplies the lower ones, so the whole costs a few M(n).  It wants the
+    // top limb at least BASE / 4: a is scaled by c^2 for that and the root
+    // and remainder scaled back.
+    friend pair<BigInt, BigInt> sqrt_rem(const BigInt &a) {
+        assert(a.sign > 0 || a.isZero());
+        if (a.isZero()) return make_pair(BigInt(0), BigInt(0));
+        int top = a.a.back(), c = 1;
+        while ((long long) (top + 1) * (c + 1) * (c + 1) <= BASE)
+            ++c;
+        if (c == 1) return sqrt_rem_normalized(a);
+
+        // a c^2 = (c s + t)^2 + r' with t < c: r = (r' + t (2 (c s + t) - t)) / c^2.
+        auto sr = sqrt_rem_normalized(a * (c * c));
+        int t = sr.first % c;
+        BigInt s = sr.first / c, r = sr.second + (sr.first * 2 - t) * t;
+        r /= c * c;
+        return make_pair(s, r);
+    }
+    static pair<BigInt, BigInt> sqrt_rem_normalized(const BigInt &a) {
+        int n = a.a.size(), l = (n - 1) / 4;
+        if (!l) {
+            // At most four limbs: a < 10^36 < 2^120, the root fits in a word.
+            unsigned __int128 v = 0;
+            for (int i = n - 1; i >= 0; --i)
+                v = v * BASE + a.a[i];
+            unsigned long long s = sqrtl((long double) v);
+            while ((unsigned __int128) s * s > v)
+                --s;
+            while ((unsigned __int128) (s + 1) * (s + 1) <= v)
+                ++s;
+            v -= (unsigned __int128) s * s;
+            BigInt r;
+            for (; v; v /= BASE)
+                r.a.push_back((int) (v % BASE));
+            return make_pair(BigInt((long long) s), r);
+        }
+        // a = a3 B^3 + a2 B^2 + a1 B + a0, B = BASE^l.
+        BigInt a1, a0;
+        a1.a.assign(a.a.begin() + l, a.a.begin() + 2 * l);
+        a0.a.assign(a.a.begin(), a.a.begin() + l);
+        a1.trim();
+        a0.trim();
+        auto sr = sqrt_rem_normalized(a.shift_limbs(-2 * l));
+        auto qu = divmod(sr.second.shift_limbs(l) + a1, sr.first * 2);
+        BigInt s = sr.first.shift_limbs(l) + qu.first;
+        BigInt r = qu.second.shift_limbs(l) + a0 - qu.first * qu.first;
+        while (r < 0) {
+            r += s * 2 - 1;
+            s -= 1;
+        }
+        return make_pair(s, r);
+    }
+    friend BigInt sqrt(const BigInt &a) {
+        return sqrt_rem(a).first;
+    }
+
+    // floor(a^(1/k)) and a - floor(a^(1/k))^k for a >= 0, k >= 1: as
+    // sqrt_rem, the root of a / BASE^kj, j = (n - 1) / 2k, refined by one
+    // step of x' = ((k - 1) x + a / x^(k-1)) / k.
+    friend pair<BigInt, BigInt> nth_root_rem(const BigInt &a, int k) {
+        assert(k >= 1 && (a.sign > 0 || a.isZero()));
+        if (k == 1) return make_pair(a, BigInt(0));
+        if (k == 2) return sqrt_rem(a);
+        int n = a.a.size(), j = (n - 1) / (2 * k);
+        BigInt s;
+        if (!j) {
+            s = root_newton(a, k);
+        } else {
+            BigInt x = (nth_root_rem(a.shift_limbs(-k * j), k).first + 1).shift_limbs(j);
+            s = (x * (k - 1) + a / pow(x, k - 1)) / k;
+        }
+        BigInt r = a - pow(s, k);
+        while (r < 0) {
+            s -= 1;
+            r = a - pow(s, k);
+        }
+        return make_pair(s, r);
+    }
+    friend BigInt nth_root(const BigInt &a, int k) {
+        return nth_root_rem(a, k).first;
+    }
+
+    // floor(a^(1/k)) for a root below BASE^2: Newton's iteration from above,
+    // started just over a floating point estimate from the top three limbs.
+    static BigInt root_newton(const BigInt &a, int k) {
+        if (a.isZero()) return 0;
+        int n = a.a.size();
+        // Three limbs: with a top limb as small as 1 two would leave only
+        // nine correct digits of a root of up to eighteen.
+        long double top = a.a[n - 1];
+        for (int i = n - 2; i >= max(n - 3, 0); --i)
+            top += a.a[i] / powl((long double) BASE, n - 1 - i);
+        long double lg = (logl(top) + (n - 1) * logl((long double) BASE)) / k;
+        // Raised well past the rounding errors of logl and expl, so Newton
+        // starts above the root and only steps down.
+        BigInt s = (long long) (expl(lg) * (1 + ldexpl(1, -30))) + 2;
+        while (pow(s, k) <= a)
+            s *= 2;
+        for (;;) {
+            BigInt next = (s * (k - 1) + a / pow(s, k - 1)) / k;
+            if (next >= s) break;
+            s = std::move(next);
+        }
+        return s;
+    }
+
+    // Digit-by-digit square root, kept as the reference for sqrt_rem.
+    static BigInt sqrt_simple(const BigInt &a1) {
         BigInt a = a1;
         while (a.a.empty() || a.a.size() % 2 == 1)
             a.a.push_back(0);
@@ -593,4 +2429,35 @@ struct BigInt {
         res.trim();
         return res / norm;
     }
+
+    // -------------------- Misc --------------------
+    BigInt abs() const & {
+        BigInt res = *this;
+        res.sign *= res.sign;
+        return res;
+    }
+    BigInt abs() && {
+        sign = 1;
+        return std::move(*this);
+    }
+    void trim() {
+        while (!a.empty() && !a.back())
+            a.pop_back();
+        if (a.empty())
+            sign = 1;
+    }
+
+    bool isZero() const {
+        return a.empty() || (a.size() == 1 && !a[0]);
+    }
+
+    // Binary exponentiation, the squarings go through the squaring kernels.
+    friend BigInt pow(BigInt base, unsigned long long e) {
+        BigInt res = 1;
+        for (; e; e >>= 1) {
+            if (e & 1) res *= base;
+            if (e > 1) base *= base;
+        }
+        return res;
+    }
 };
@@ -0,0 +1,218 @@
+#pragma once
+// BigIntAccumulator: a running sum of many BigInts with deferred carries.
+//
+// res += x on a BigInt propagates a carry through every limb, compares
+// magnitudes when the signs differ and trims the result, every time.  Here
+// the sum is kept in signed 64-bit limbs that are never normalized on the
+// way: adding or subtracting x is one pass of plain limb additions with no
+// dependency between limbs, which the compiler vectorizes.  Limbs of x are
+// below BASE < 2^30, so about 2^62 / BASE additions fit before a limb could
+// overflow; the accumulator normalizes itself after that many, and when the
+// value is read.
+//
+// Sums of up to INLINE_LIMBS limbs stay inside the object; longer ones take
+// a block from the current LimbResource, the way BigInt's limbs do, so the
+// calculator's sums land in its arena next to the numbers.
+//
+// Before including this header one needs what bigint.h needs and bigint.h.
+
+class BigIntAccumulator {
+  public:
+    BigIntAccumulator() {}
+
+    explicit BigIntAccumulator(const BigInt &x) {
+        *this += x;
+    }
+
+    // Starts over from x, the limb buffer is kept.
+    BigIntAccumulator &operator=(const BigInt &x) {
+        acc_.clear();
+        pending_ = 0;
+        return *this += x;
+    }
+
+    BigIntAccumulator &operator+=(const BigInt &x) {
+        if (x.sign > 0) {
+            add(x);
+        } else {
+            sub(x);
+        }
+        return *this;
+    }
+
+    BigIntAccumulator &operator-=(const BigInt &x) {
+        if (x.sign > 0) {
+            sub(x);
+        } else {
+            add(x);
+        }
+        return *this;
+    }
+
+    // The sum as a BigInt; normalizes the limbs.
+    BigInt value() {
+        normalize();
+        BigInt res;
+        int n = acc_.size();
+        if (!n) return res;
+        // After normalize() all limbs but the top one are in [0, BASE).
+        long long top = acc_[n - 1];
+        res.a.resize(n - 1);
+        for (int i = 0; i < n - 1; ++i)
+            res.a[i] = (int) acc_[i];
+        if (top >= 0) {
+            for (; top; top /= BASE)
+                res.a.push_back((int) (top % BASE));
+            res.trim();
+        } else {
+            res.trim();
+            res -= BigInt(-top).shift_limbs(n - 1);
+        }
+        return res;
+    }
+
+  private:
+    // The subset of vector<long long> the accumulator uses, a LimbVector
+    // for 64-bit limbs without the sharing.
+    class Limbs {
+      public:
+        static const int INLINE_LIMBS = 8;
+
+        Limbs() : data_(inline_), size_(0), capacity_(INLINE_LIMBS), resource_(nullptr) {}
+        Limbs(const Limbs &v) : Limbs() {
+            *this = v;
+        }
+        ~Limbs() {
+            release();
+        }
+        Limbs &operator=(const Limbs &v) {
+            if (this != &v) {
+                clear();
+                resize(v.size_);
+                copy(v.data_, v.data_ + v.size_, data_);
+            }
+            return *this;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+        bool empty() const {
+            return size_ == 0;
+        }
+        long long *data() {
+            return data_;
+        }
+        long long &operator[](size_t i) {
+            return data_[i];
+        }
+        long long &back() {
+            return data_[size_ - 1];
+        }
+
+        void clear() {
+            size_ = 0;
+        }
+        void push_back(long long x) {
+            if (size_ == capacity_) reallocate(2 * capacity_);
+            data_[size_++] = x;
+        }
+        void pop_back() {
+            --size_;
+        }
+        // New limbs are zero.
+        void resize(size_t n) {
+            if (n > capacity_) reallocate(max(n, 2 * capacity_));
+            if (n > size_) fill(data_ + size_, data_ + n, 0LL);
+            size_ = n;
+        }
+
+      private:
+        long long *data_;
+        size_t size_;
+        size_t capacity_;
+        // Where the heap block came from, nullptr for operator new[].
+        LimbResource *resource_;
+        long long inline_[INLINE_LIMBS];
+
+        void reallocate(size_t n) {
+            LimbResource *resource = LimbResource::current();
+            long long *p =
+                resource ? (long long *) resource->allocate(n * sizeof(long long)) : nullptr;
+            if (!p) {
+                resource = nullptr;
+                p = new long long[n];
+            }
+            copy(data_, data_ + size_, p);
+            release();
+            data_ = p;
+            capacity_ = n;
+            resource_ = resource;
+        }
+
+        void release() {
+            if (data_ != inline_) {
+                if (resource_)
+                    resource_->deallocate(data_, capacity_ * sizeof(long long));
+                else
+                    delete[] data_;
+            }
+            data_ = inline_;
+            capacity_ = INLINE_LIMBS;
+            resource_ = nullptr;
+        }
+    };
+
+    // Sum of the limbs of the added BigInts, signed, least significant first.
+    Limbs acc_;
+    // Additions since the last normalize().
+    long long pending_ = 0;
+
+    static const long long MAX_PENDING = (1LL << 62) / BASE;
+
+    void add(const BigInt &x) {
+        int n = x.a.size();
+        if ((int) acc_.size() < n) acc_.resize(n);
+        long long *acc = acc_.data();
+        const int *a = x.a.data();
+        for (int i = 0; i < n; ++i)
+            acc[i] += a[i];
+        if (++pending_ == MAX_PENDING) normalize();
+    }
+
+    void sub(const BigInt &x) {
+        int n = x.a.size();
+        if ((int) acc_.size() < n) acc_.resize(n);
+        long long *acc = acc_.data();
+        const int *a = x.a.data();
+        for (int i = 0; i < n; ++i)
+            acc[i] -= a[i];
+        if (++pending_ == MAX_PENDING) normalize();
+    }
+
+    // Floor-divides every limb but the top one by BASE and carries the
+    // quotient up: the limbs end in [0, BASE), the sign sits in the top limb,
+    // which grows by at most one limb per normalize().
+    void normalize() {
+        long long carry = 0;
+        int n = acc_.size();
+        for (int i = 0; i + 1 < n; ++i) {
+            long long cur = acc_[i] + carry;
+            carry = cur / BASE;
+            cur %= BASE;
+            if (cur < 0) cur += BASE, --carry;
+            acc_[i] = cur;
+        }
+        if (n) acc_[n - 1] += carry;
+        if (n && (acc_[n - 1] >= BASE || acc_[n - 1] <= -BASE)) {
+            long long top = acc_[n - 1];
+            long long high = top / BASE, low = top % BASE;
+            if (low < 0) low += BASE, --high;
+            acc_[n - 1] = low;
+            acc_.push_back(high);
+        }
+        while (!acc_.empty() && !acc_.back())
+            acc_.pop_back();
+        pending_ = 0;
+    }
+};
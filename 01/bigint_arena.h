@@ -0,0 +1,49 @@
+#pragma once
+// Арены для лимбов BigInt поверх LinearAllocator из второго задания.
+// Перед включением нужен bigint.h.
+#include "../02/linear_allocator.h"
+
+// Адаптер LinearAllocator к LimbResource. Освобождать отдельные блоки
+// линейный аллокатор не умеет, память возвращается вся сразу в reset().
+// Буфер из malloc выровнен, а размеры блоков округляем до sizeof(long long):
+// так выровнен и каждый следующий блок, в том числе под 64-битные лимбы
+// BigIntAccumulator.
+class LinearAllocatorResource : public LimbResource {
+  public:
+    explicit LinearAllocatorResource(LinearAllocator &allocator)
+        : m_allocator(allocator) {}
+
+    void *allocate(size_t bytes) override {
+        const size_t align = sizeof(long long);
+        return m_allocator.alloc((bytes + align - 1) / align * align);
+    }
+    void deallocate(void *, size_t) override {}
+
+  private:
+    LinearAllocator &m_allocator;
+};
+
+/**
+ * @brief Арена на одно вычисление: все лимбы, выделенные внутри, берутся из
+ * LinearAllocator, а по reset() возвращаются разом за O(1).
+ *
+ * Когда арена кончается, лимбы молча уходят в обычную кучу. Перед reset()
+ * все числа, взявшие память из арены, должны быть уничтожены или скопированы
+ * за пределами LimbResourceScope с этой ареной.
+ */
+class BigIntArena {
+  public:
+    explicit BigIntArena(size_t maxSize)
+        : m_allocator(maxSize), m_resource(m_allocator) {}
+
+    LimbResource *resource() {
+        return &m_resource;
+    }
+    void reset() {
+        m_allocator.reset();
+    }
+
+  private:
+    LinearAllocator m_allocator;
+    LinearAllocatorResource m_resource;
+};
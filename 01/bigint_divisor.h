@@ -0,0 +1,75 @@
+#pragma once
+// BigIntDivisor: many dividends, one divisor.
+//
+// divmod(a, b) normalizes b for Algorithm D, divides by its top limb in every
+// step and, for long operands, recomputes the Newton reciprocal of b on each
+// call.  Here all of that is done once in the constructor: the normalized
+// divisor, a LimbDivisor for its top limb (or for b itself when b fits in a
+// limb, the operator/=(int) case) and, for divisors of NEWTON_THRESHOLD limbs
+// and more, reciprocal(b).  Results and signs are those of divmod, / and %.
+//
+// Before including this header one needs what bigint.h needs and bigint.h.
+
+class BigIntDivisor {
+  public:
+    explicit BigIntDivisor(const BigInt &b) : b_(b.abs()), sign_(b.sign) {
+        assert(!b.isZero());
+        int m = b_.a.size();
+        if (m == 1) {
+            top_ = LimbDivisor(b_.a[0]);
+            return;
+        }
+        norm_ = BASE / (b_.a.back() + 1);
+        BigInt v = b_ * norm_;
+        v_.assign(v.a.begin(), v.a.end());
+        top_ = LimbDivisor(v_[m - 1]);
+        if (m >= BigInt::NEWTON_THRESHOLD) reciprocal_ = BigInt::reciprocal(b_);
+    }
+
+    BigInt divisor() const {
+        return sign_ < 0 ? -b_ : b_;
+    }
+
+    pair<BigInt, BigInt> divmod(const BigInt &a) const {
+        auto res = divmod_unsigned(a);
+        res.first.sign = a.sign * sign_;
+        res.second.sign = a.sign;
+        res.first.trim();
+        res.second.trim();
+        if (res.second < 0) res.second += divisor();
+        return res;
+    }
+
+    BigInt div(const BigInt &a) const {
+        return divmod(a).first;
+    }
+
+    // A one-limb divisor needs only the running remainder, no quotient.
+    BigInt mod(const BigInt &a) const {
+        if (b_.a.size() > 1) return divmod(a).second;
+        long long rem = 0, q;
+        for (int i = (int) a.a.size() - 1; i >= 0; --i)
+            top_.divide(a.a[i] + rem * BASE, q, rem);
+        BigInt res = a.sign < 0 ? -rem : rem;
+        if (res < 0) res += divisor();
+        return res;
+    }
+
+  private:
+    BigInt b_; // |b|
+    int sign_;
+    int norm_ = 1;
+    LimbVector v_; // b_ * norm_, top limb at least BASE / 2
+    LimbDivisor top_;
+    BigInt reciprocal_; // BASE^2m / b_, long divisors only
+
+    // |a| by |b|: the kernels only read the limbs of a, its sign is fixed up
+    // by the caller, so no copy for abs().
+    pair<BigInt, BigInt> divmod_unsigned(const BigInt &a) const {
+        int n = a.a.size(), m = b_.a.size();
+        if (m == 1) return BigInt::divmod_limb(a, top_);
+        if (!reciprocal_.isZero() && n - m >= BigInt::NEWTON_THRESHOLD)
+            return BigInt::divmod_reciprocal(a, b_, reciprocal_);
+        return BigInt::divmod_normalized(a, v_, norm_, top_);
+    }
+};
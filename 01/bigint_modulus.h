@@ -0,0 +1,222 @@
+#pragma once
+// BigIntModulus: arithmetic modulo a fixed m > 0 without the general division.
+//
+// a^e mod m through '*' and '%' pays a full divmod for every product.  Here
+// m is fixed once and Barrett's constant mu = BASE^2k / m (k limbs in m) is
+// computed in the constructor; after that a reduction of x < BASE^2k costs two
+// multiplications by the tiers of operator* plus at most two subtractions.
+// Barrett rather than Montgomery: it needs no odd modulus and no conversion
+// of the operands, and BASE = 10^9 gives no cheap Montgomery radix anyway.
+//
+// Before including this header one needs what bigint.h needs and bigint.h.
+
+class BigIntModulus {
+  public:
+    explicit BigIntModulus(const BigInt &m)
+        : m_(m), k_(m.a.size()), mu_(BigInt(1).shift_limbs(2 * m.a.size()) / m) {
+        assert(m.sign > 0 && !m.isZero());
+        one_ = m_ == 1 ? 0 : 1;
+    }
+
+    const BigInt &modulus() const {
+        return m_;
+    }
+
+    // x mod m in [0, m) for any x: k limbs at a time from the top, every step
+    // reduces r * BASE^k + chunk < m * BASE^k.
+    BigInt residue(const BigInt &x) const {
+        BigInt r;
+        int n = x.a.size();
+        if (n <= 2 * k_) {
+            r = reduce(x.abs());
+        } else {
+            for (int i = (n - 1) / k_ * k_; i >= 0; i -= k_) {
+                BigInt chunk;
+                chunk.a.assign(x.a.begin() + i, x.a.begin() + min(i + k_, n));
+                chunk.trim();
+                r = reduce(r.shift_limbs(k_) + chunk);
+            }
+        }
+        if (x.sign < 0 && !r.isZero()) r = m_ - r;
+        return r;
+    }
+
+    // a * b mod m for residues a, b; mulmod(x, x) takes the squaring kernels.
+    BigInt mulmod(const BigInt &a, const BigInt &b) const {
+        assert(is_residue(a) && is_residue(b));
+        return reduce(a * b);
+    }
+
+    // base^e mod m for e >= 0, left-to-right sliding window over the bits of e
+    // with the odd powers base, base^3, ..., base^(2^w - 1) precomputed.
+    BigInt powmod(const BigInt &base, const BigInt &e) const {
+        assert(e.sign > 0 || e.isZero());
+        vector<int> bits = binary_digits(e);
+        int n = bits.size();
+        if (!n) return one_;
+
+        int w = n > 671 ? 6 : n > 239 ? 5 : n > 79 ? 4 : n > 23 ? 3 : n > 6 ? 2 : 1;
+        vector<BigInt> powers(1 << (w - 1));
+        powers[0] = residue(base);
+        if (powers.size() > 1) {
+            BigInt square = mulmod(powers[0], powers[0]);
+            for (size_t i = 1; i < powers.size(); ++i)
+                powers[i] = mulmod(powers[i - 1], square);
+        }
+
+        BigInt res = one_;
+        bool first = true;
+        for (int i = n - 1; i >= 0;) {
+            if (!bits[i]) {
+                res = mulmod(res, res);
+                --i;
+                continue;
+            }
+            int j = max(i - w + 1, 0);
+            while (!bits[j])
+                ++j;
+            int window = 0;
+            for (int l = i; l >= j; --l)
+                window = window * 2 + bits[l];
+            if (first) {
+                res = powers[window >> 1];
+                first = false;
+            } else {
+                for (int l = i; l >= j; --l)
+                    res = mulmod(res, res);
+                res = mulmod(res, powers[window >> 1]);
+            }
+            i = j - 1;
+        }
+        return res;
+    }
+    BigInt powmod(const BigInt &base, unsigned long long e) const {
+        BigInt res = one_, b = residue(base);
+        for (; e; e >>= 1) {
+            if (e & 1) res = mulmod(res, b);
+            if (e > 1) b = mulmod(b, b);
+        }
+        return res;
+    }
+
+    // x with a * x = 1 mod m, or 0 when gcd(a, m) != 1.  Binary extended
+    // Euclid (Handbook of Applied Cryptography, 14.61): only halvings,
+    // additions and subtractions, no quotients.
+    BigInt invmod(const BigInt &a) const {
+        BigInt x = residue(a);
+        if (m_ == 1 || x.isZero()) return 0;
+        if (!odd(x) && !odd(m_)) return 0;
+
+        // Invariants: A * x + B * m = u, C * x + D * m = v.
+        BigInt u = x, v = m_, A = 1, B = 0, C = 0, D = 1;
+        while (!u.isZero()) {
+            while (!odd(u)) {
+                halve(u);
+                if (odd(A) || odd(B)) A += m_, B -= x;
+                halve(A), halve(B);
+            }
+            while (!odd(v)) {
+                halve(v);
+                if (odd(C) || odd(D)) C += m_, D -= x;
+                halve(C), halve(D);
+            }
+            if (u >= v) {
+                u -= v, A -= C, B -= D;
+            } else {
+                v -= u, C -= A, D -= B;
+            }
+        }
+        if (v != 1) return 0;
+        return residue(C);
+    }
+
+  private:
+    BigInt m_;
+    int k_;
+    BigInt mu_;
+    BigInt one_; // 1 mod m
+
+    bool is_residue(const BigInt &x) const {
+        return x.sign > 0 && x < m_;
+    }
+
+    // x mod m for 0 <= x < BASE^2k.  q = x / BASE^(k-1) * mu / BASE^(k+1)
+    // undershoots x / m by at most 2, so r = x - q * m is in [0, 3m).
+    // Below the Karatsuba threshold only the limbs that matter are
+    // multiplied (HAC 14.42): the top of x / BASE^(k-1) * mu, which drops a
+    // few more units of q, and x - q * m modulo BASE^(k+1), which is exact
+    // since r < BASE^(k+1).  Above it the tiers of operator* win anyway.
+    BigInt reduce(const BigInt &x) const {
+        assert(x.sign > 0 && (int) x.a.size() <= 2 * k_);
+        if (x < m_) return x;
+        BigInt r;
+        if (k_ < BigInt::thresholds().karatsuba) {
+            BigInt q = partial_product(x.shift_limbs(1 - k_), mu_, k_ - 1, 2 * k_ + 2)
+                           .shift_limbs(-k_ - 1);
+            r.a.assign(x.a.begin(), x.a.begin() + min((int) x.a.size(), k_ + 1));
+            r.trim();
+            r -= partial_product(q, m_, 0, k_ + 1);
+            if (r < 0) r += BigInt(1).shift_limbs(k_ + 1);
+        } else {
+            BigInt q = (x.shift_limbs(1 - k_) * mu_).shift_limbs(-k_ - 1);
+            r = x - q * m_;
+        }
+        while (r >= m_)
+            r -= m_;
+        return r;
+    }
+
+    // Schoolbook a * b with only the limb products a[i] * b[j], from <= i + j
+    // < to, and the carries cut at limb 'to'.
+    static BigInt partial_product(const BigInt &a, const BigInt &b, int from, int to) {
+        BigInt res;
+        int n = a.a.size(), m = b.a.size();
+        res.a.resize(min(n + m, to));
+        for (int i = 0; i < n && i < to; ++i) {
+            if (!a.a[i]) continue;
+            int j = max(from - i, 0), carry = 0;
+            for (; j < m && i + j < to; ++j) {
+                long long cur = res.a[i + j] + (long long) a.a[i] * b.a[j] + carry;
+                carry = (int) (cur / BASE);
+                res.a[i + j] = (int) (cur % BASE);
+            }
+            for (; carry && i + j < to; ++j) {
+                long long cur = res.a[i + j] + (long long) carry;
+                carry = (int) (cur / BASE);
+                res.a[i + j] = (int) (cur % BASE);
+            }
+        }
+        res.trim();
+        return res;
+    }
+
+    // BASE is even, so the parity of x is the parity of its lowest limb.
+    static bool odd(const BigInt &x) {
+        return !x.a.empty() && (x.a[0] & 1);
+    }
+
+    // Exact halving of an even x of either sign.
+    static void halve(BigInt &x) {
+        for (int i = (int) x.a.size() - 1, rem = 0; i >= 0; --i) {
+            int cur = x.a[i];
+            x.a[i] = (cur >> 1) + (rem ? BASE / 2 : 0);
+            rem = cur & 1;
+        }
+        x.trim();
+    }
+
+    // Bits of e >= 0, least significant first, 29 per pass: 2^29 < BASE.
+    static vector<int> binary_digits(BigInt e) {
+        const int CHUNK = 29;
+        vector<int> bits;
+        while (!e.isZero()) {
+            int low = e % (1 << CHUNK);
+            e /= 1 << CHUNK;
+            for (int i = 0; i < CHUNK; ++i)
+                bits.push_back(low >> i & 1);
+        }
+        while (!bits.empty() && !bits.back())
+            bits.pop_back();
+        return bits;
+    }
+};
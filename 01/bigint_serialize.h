@@ -0,0 +1,315 @@
+#pragma once
+// Binary storage of BigInts: a versioned limb format for streams and files,
+// and read-only views straight into a memory-mapped file.  Also decimal
+// text on raw file descriptors, chunk by chunk.
+//
+// Decimal text through << and read() costs a full format and parse, and
+// about twice the space of the limbs (nine digits plus a separator for four
+// bytes).  Here the limbs are written as they are in memory:
+//
+//   file   = header record*
+//   header = magic "BIGINT\r\n", version, BASE_DIGITS, byte order mark, 0
+//            (24 bytes in all)
+//   record = sign (+1 / -1), n, then n limbs least significant first
+//            (32-bit words, zero is n = 0 with sign +1)
+//
+// Every field is a 32-bit word in the byte order of the writer, so a mapped
+// file keeps the limbs 4-byte aligned and BigIntView can point right into
+// it.  Readers refuse another version, another BASE_DIGITS or the other
+// byte order with BigIntFormatError; a truncated record or a bad sign throws
+// it too.  The limbs themselves are trusted: a view does not touch them
+// until asked to.
+//
+// Before including this header one needs what bigint.h needs and bigint.h.
+// The mapping is POSIX, its headers are included below.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class BigIntFormatError {};
+
+const int BIGINT_FORMAT_VERSION = 1;
+
+struct BigIntFileHeader {
+    char magic[8];
+    unsigned version;
+    unsigned base_digits;
+    unsigned byte_order;
+    unsigned reserved;
+
+    static const unsigned BYTE_ORDER_MARK = 0x01020304;
+
+    static BigIntFileHeader current() {
+        BigIntFileHeader h = {{'B', 'I', 'G', 'I', 'N', 'T', '\r', '\n'},
+                              BIGINT_FORMAT_VERSION, BASE_DIGITS, BYTE_ORDER_MARK, 0};
+        return h;
+    }
+
+    void check() const {
+        BigIntFileHeader expected = current();
+        if (memcmp(magic, expected.magic, sizeof(magic)) || version != expected.version ||
+            base_digits != expected.base_digits || byte_order != expected.byte_order)
+            throw BigIntFormatError();
+    }
+};
+
+// -------------------- Streams --------------------
+inline void write_binary_header(ostream &out) {
+    BigIntFileHeader header = BigIntFileHeader::current();
+    out.write((const char *) &header, sizeof(header));
+}
+
+// Reads and checks the header, false on an empty stream.
+inline bool read_binary_header(istream &in) {
+    BigIntFileHeader header;
+    if (!in.read((char *) &header, sizeof(header))) {
+        if (in.gcount() == 0) return false;
+        throw BigIntFormatError();
+    }
+    header.check();
+    return true;
+}
+
+inline void write_binary(ostream &out, const BigInt &x) {
+    int record[2] = {x.isZero() ? 1 : x.sign, x.isZero() ? 0 : (int) x.a.size()};
+    out.write((const char *) record, sizeof(record));
+    out.write((const char *) x.a.data(), record[1] * sizeof(int));
+}
+
+// Limbs read by read_binary at a time.
+const int BINARY_CHUNK = 1 << 16;
+
+// The next record into x, false at the end of the stream.  The limb count
+// of a record is not trusted: the limbs grow a chunk at a time as they
+// arrive, so a corrupt count costs no more memory than the stream holds.
+inline bool read_binary(istream &in, BigInt &x) {
+    int record[2];
+    if (!in.read((char *) record, sizeof(record))) {
+        if (in.gcount() == 0) return false;
+        throw BigIntFormatError();
+    }
+    if ((record[0] != 1 && record[0] != -1) || record[1] < 0) throw BigIntFormatError();
+    x.sign = record[0];
+    x.a.clear();
+    for (int done = 0; done < record[1];) {
+        int take = min(BINARY_CHUNK, record[1] - done);
+        x.a.resize(done + take);
+        if (!in.read((char *) (x.a.data() + done), take * sizeof(int)))
+            throw BigIntFormatError();
+        done += take;
+    }
+    x.trim();
+    return true;
+}
+
+// -------------------- Views --------------------
+// A BigInt that someone else owns: sign and limbs in BigInt's layout, read
+// in place.  Valid while the memory behind it is.
+class BigIntView {
+  public:
+    BigIntView() : sign_(1), size_(0), limbs_(nullptr) {}
+    BigIntView(int sign, int size, const int *limbs)
+        : sign_(sign), size_(size), limbs_(limbs) {}
+    explicit BigIntView(const BigInt &x)
+        : sign_(x.sign), size_(x.a.size()), limbs_(x.a.data()) {}
+
+    int sign() const {
+        return sign_;
+    }
+    int size() const {
+        return size_;
+    }
+    const int *limbs() const {
+        return limbs_;
+    }
+    int operator[](int i) const {
+        return limbs_[i];
+    }
+    bool isZero() const {
+        return size_ == 0 || (size_ == 1 && !limbs_[0]);
+    }
+
+    // The one copy of the limbs, for when arithmetic is needed.
+    BigInt to_bigint() const {
+        BigInt res;
+        res.a.assign(limbs_, limbs_ + size_);
+        res.sign = sign_;
+        res.trim();
+        return res;
+    }
+
+    // Same order as BigInt's operator<, for trimmed limbs.
+    friend int compare(const BigIntView &l, const BigIntView &r) {
+        int sl = l.isZero() ? 0 : l.sign_, sr = r.isZero() ? 0 : r.sign_;
+        if (sl != sr) return sl < sr ? -1 : 1;
+        if (l.size_ != r.size_) return l.size_ < r.size_ ? -sl : sl;
+        for (int i = l.size_ - 1; i >= 0; --i)
+            if (l.limbs_[i] != r.limbs_[i])
+                return l.limbs_[i] < r.limbs_[i] ? -sl : sl;
+        return 0;
+    }
+    friend bool operator<(const BigIntView &l, const BigIntView &r) {
+        return compare(l, r) < 0;
+    }
+    friend bool operator==(const BigIntView &l, const BigIntView &r) {
+        return compare(l, r) == 0;
+    }
+    friend bool operator!=(const BigIntView &l, const BigIntView &r) {
+        return compare(l, r) != 0;
+    }
+
+    // Decimal, as BigInt prints it.
+    friend ostream &operator<<(ostream &stream, const BigIntView &v) {
+        BigInt::write_decimal(v.sign_, v.limbs_, v.size_,
+                              [&](const char *p, size_t n) { stream.write(p, n); });
+        return stream;
+    }
+
+  private:
+    int sign_;
+    int size_;
+    const int *limbs_;
+};
+
+// -------------------- Mapped files --------------------
+// A file in the format above mapped read-only; the records are views into
+// the mapping, found by one pass over the record headers on open.  Like
+// ifstream, a file that cannot be opened leaves is_open() false; a file that
+// is not in the format throws BigIntFormatError.
+class BigIntMappedFile {
+  public:
+    explicit BigIntMappedFile(const char *path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return;
+        }
+        if ((size_t) st.st_size < sizeof(BigIntFileHeader)) {
+            close(fd);
+            throw BigIntFormatError();
+        }
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return;
+        data_ = (const char *) p;
+        bytes_ = st.st_size;
+        try {
+            index();
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+    ~BigIntMappedFile() {
+        unmap();
+    }
+    BigIntMappedFile(const BigIntMappedFile &) = delete;
+    BigIntMappedFile &operator=(const BigIntMappedFile &) = delete;
+
+    bool is_open() const {
+        return data_ != nullptr;
+    }
+    size_t size() const {
+        return views_.size();
+    }
+    const BigIntView &operator[](size_t i) const {
+        return views_[i];
+    }
+    vector<BigIntView>::const_iterator begin() const {
+        return views_.begin();
+    }
+    vector<BigIntView>::const_iterator end() const {
+        return views_.end();
+    }
+
+  private:
+    const char *data_ = nullptr;
+    size_t bytes_ = 0;
+    vector<BigIntView> views_;
+
+    void index() {
+        ((const BigIntFileHeader *) data_)->check();
+        const int *p = (const int *) (data_ + sizeof(BigIntFileHeader));
+        const int *end = (const int *) (data_ + bytes_);
+        if ((bytes_ - sizeof(BigIntFileHeader)) % sizeof(int)) throw BigIntFormatError();
+        while (p < end) {
+            if (end - p < 2 || (p[0] != 1 && p[0] != -1) || p[1] < 0 || end - p - 2 < p[1])
+                throw BigIntFormatError();
+            views_.push_back(BigIntView(p[0], p[1], p + 2));
+            p += 2 + p[1];
+        }
+    }
+
+    void unmap() {
+        if (data_) munmap((void *) data_, bytes_);
+        data_ = nullptr;
+    }
+};
+
+// -------------------- Decimal on file descriptors --------------------
+// Reads one decimal number from fd in chunks of DECIMAL_CHUNK bytes through
+// BigInt::DecimalReader: leading whitespace, signs, digits.  A descriptor
+// cannot take bytes back, so whatever follows the number in the last chunk
+// is consumed.  For a regular file the limbs are reserved from its size up
+// front, and the limb vector is all the memory the number takes.  A read
+// interrupted by a signal is retried.  False if there were no digits or on
+// a read error.
+const int DECIMAL_CHUNK = 1 << 16;
+
+inline bool read_decimal(int fd, BigInt &x) {
+    BigInt::DecimalReader reader(x);
+    struct stat st;
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && pos >= 0 && st.st_size > pos)
+        x.a.reserve((st.st_size - pos) / BASE_DIGITS + 1);
+    vector<char> chunk(DECIMAL_CHUNK);
+    bool number = false;
+    for (;;) {
+        ssize_t n = read(fd, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) break;
+        const char *p = chunk.data(), *end = p + n;
+        if (!number) {
+            while (p < end && isspace((unsigned char) *p))
+                ++p;
+            number = p < end;
+        }
+        if (p < end && (size_t) (end - p) > reader.feed(p, end - p)) break;
+    }
+    return reader.finish();
+}
+
+// Writes x in decimal to fd through a buffer of DECIMAL_CHUNK bytes,
+// retrying writes interrupted by a signal.  False on a write error.
+inline bool write_decimal(int fd, const BigInt &x) {
+    vector<char> chunk;
+    chunk.reserve(DECIMAL_CHUNK);
+    bool ok = true;
+    auto flush = [&] {
+        const char *p = chunk.data();
+        size_t n = chunk.size();
+        while (ok && n) {
+            ssize_t written = write(fd, p, n);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) {
+                ok = false;
+            } else {
+                p += written;
+                n -= written;
+            }
+        }
+        chunk.clear();
+    };
+    x.write_decimal([&](const char *p, size_t n) {
+        if (chunk.size() + n > DECIMAL_CHUNK) flush();
+        chunk.insert(chunk.end(), p, p + n);
+    });
+    flush();
+    return ok;
+}
@@ -0,0 +1,83 @@
+#pragma once
+// Products and sums of many numbers through a balanced tree.
+//
+// x1 * x2 * ... * xn left to right multiplies an ever longer accumulator by
+// one short factor at a time, which costs O(n^2) limb products whatever the
+// multiplication algorithm.  Halving the range instead keeps both operands
+// of every multiplication of about the same size, so the big ones get to the
+// Karatsuba, Toom and NTT tiers and the total is O(M(N) log n) for a result
+// of N limbs.  Works for any Int with a constructor from long long, += and
+// *= (BigInt, BinaryBigInt); move iterators let the leaves be moved out.
+//
+// Before including this header one needs <iterator> and bigint.h.
+
+template <typename Int, typename It>
+Int product_tree(It first, size_t n) {
+    if (n == 1) return *first;
+    It middle = first;
+    advance(middle, n / 2);
+    Int left = product_tree<Int>(first, n / 2);
+    Int right = product_tree<Int>(middle, n - n / 2);
+    left *= right;
+    return left;
+}
+
+template <typename Int, typename It>
+Int sum_tree(It first, size_t n) {
+    if (n == 1) return *first;
+    It middle = first;
+    advance(middle, n / 2);
+    Int left = sum_tree<Int>(first, n / 2);
+    Int right = sum_tree<Int>(middle, n - n / 2);
+    left += right;
+    return left;
+}
+
+// Product of [first, last), 1 for an empty range.
+template <typename It>
+typename iterator_traits<It>::value_type product(It first, It last) {
+    typedef typename iterator_traits<It>::value_type Int;
+    size_t n = distance(first, last);
+    return n ? product_tree<Int>(first, n) : Int(1);
+}
+
+// Sum of [first, last), 0 for an empty range.
+template <typename It>
+typename iterator_traits<It>::value_type sum(It first, It last) {
+    typedef typename iterator_traits<It>::value_type Int;
+    size_t n = distance(first, last);
+    return n ? sum_tree<Int>(first, n) : Int(0);
+}
+
+// from * (from + 1) * ... * to for 1 <= from, to < 2^32, 1 for an empty
+// range.  Consecutive factors are first packed into words below 10^18,
+// then the words go through the tree.
+template <typename Int = BigInt>
+Int range_product(unsigned long long from, unsigned long long to) {
+    const unsigned long long WORD = 1000000000000000000ULL;
+    vector<Int> words;
+    for (unsigned long long i = from; i <= to;) {
+        unsigned long long word = i++;
+        while (i <= to && word <= (WORD - 1) / i)
+            word *= i++;
+        words.push_back(Int((long long) word));
+    }
+    return product(make_move_iterator(words.begin()), make_move_iterator(words.end()));
+}
+
+// n!
+template <typename Int = BigInt>
+Int factorial(unsigned n) {
+    return range_product<Int>(2, n);
+}
+
+// n! / (k! (n - k)!), 0 for k > n: the top k factors of n! over k!, both
+// from the tree, then one exact division.
+template <typename Int = BigInt>
+Int binomial(unsigned n, unsigned k) {
+    if (k > n) return Int(0);
+    k = min(k, n - k);
+    Int res = range_product<Int>(n - k + 1, n);
+    res /= factorial<Int>(k);
+    return res;
+}
@@ -0,0 +1,6 @@
+// Multiplication crossover points for BigInt, in limbs of the shorter
+// operand.  Generated by 'make run_tune' (tune.cpp), rerun it on the target host.
+const int TUNED_KARATSUBA_THRESHOLD = 64;
+const int TUNED_TOOM3_THRESHOLD = 512;
+const int TUNED_TOOM4_THRESHOLD = 512;
+const int TUNED_NTT_THRESHOLD = 512;
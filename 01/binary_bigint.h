@@ -0,0 +1,680 @@
+#pragma once
+// BinaryBigInt: the BigInt interface (bigint.h) on binary base 2^64 limbs.
+//
+// A decimal limb holds log2(10^9) = 29.9 of its 32 bits and every carry
+// needs a division by 10^9.  Here limbs are full 64-bit words, carries are
+// overflow checks, products and quotients of two limbs go through unsigned
+// __int128, and shifts are shifts.  Long products go through a three-prime
+// NTT on 16-bit digits, the one BigInt uses (Transforms in bigint.h, with
+// its cached tables).  Decimal digits only appear on input and output,
+// converted by divide and conquer over cached powers 10^(19 * 2^k); the
+// divisions by those powers are multiplications by their cached Newton
+// reciprocals, so conversion costs O(M(n) log n) both ways.
+//
+// Before including this header one needs what bigint.h needs and bigint.h.
+
+struct BinaryBigInt {
+    typedef unsigned long long Limb;
+    typedef unsigned __int128 Wide;
+    typedef vector<Limb> Limbs;
+
+    // Largest power of ten in a limb: 10^19 < 2^64.
+    static const int LIMB_DIGITS = 19;
+    static const Limb LIMB_TEN_POWER = 10000000000000000000ULL;
+    static const int KARATSUBA_THRESHOLD = 32;
+    // From this many limbs in the shorter operand products go through NTT;
+    // Karatsuba on full 64-bit limbs holds out that long.
+    static const int NTT_THRESHOLD = 8192;
+    // Divisors of at least this many limbs are divided through a Newton
+    // reciprocal.
+    static const int NEWTON_THRESHOLD = 64;
+    // Below this many limbs decimal conversion goes limb by limb, the
+    // quadratic loop beats splitting there.
+    static const int DECIMAL_THRESHOLD = 32;
+
+    int sign;
+    Limbs a; // magnitude, least significant limb first, no leading zeros
+
+    // -------------------- Constructors --------------------
+    BinaryBigInt() : sign(1) {}
+
+    BinaryBigInt(long long v) {
+        *this = v;
+    }
+    BinaryBigInt &operator=(long long v) {
+        sign = v < 0 ? -1 : 1;
+        a.clear();
+        Limb m = v < 0 ? 0ULL - (Limb) v : (Limb) v;
+        if (m) a.push_back(m);
+        return *this;
+    }
+
+    BinaryBigInt(const string &s) {
+        read(s);
+    }
+
+    // -------------------- Input / Output --------------------
+    void read(const string &s) {
+        sign = 1;
+        int pos = 0;
+        while (pos < (int) s.size() && (s[pos] == '-' || s[pos] == '+')) {
+            if (s[pos] == '-')
+                sign = -sign;
+            ++pos;
+        }
+        a = from_decimal(s.data() + pos, (int) s.size() - pos);
+        trim();
+    }
+    friend istream &operator>>(istream &stream, BinaryBigInt &v) {
+        string s;
+        stream >> s;
+        v.read(s);
+        return stream;
+    }
+
+    friend ostream &operator<<(ostream &stream, const BinaryBigInt &v) {
+        if (v.sign == -1 && !v.isZero())
+            stream << '-';
+        return stream << v.to_decimal();
+    }
+
+    // Decimal digits of |*this|.
+    string to_decimal() const {
+        if (a.empty()) return "0";
+        int k = 0;
+        while (compare(a, *power_of_ten(k + 1)) >= 0)
+            ++k;
+        string out;
+        write_decimal(a, k, false, out);
+        return out;
+    }
+
+    // -------------------- Comparison --------------------
+    bool operator<(const BinaryBigInt &v) const {
+        if (sign != v.sign)
+            return sign < v.sign;
+        int c = compare(a, v.a);
+        return sign == 1 ? c < 0 : c > 0;
+    }
+    bool operator>(const BinaryBigInt &v) const {
+        return v < *this;
+    }
+    bool operator<=(const BinaryBigInt &v) const {
+        return !(v < *this);
+    }
+    bool operator>=(const BinaryBigInt &v) const {
+        return !(*this < v);
+    }
+    bool operator==(const BinaryBigInt &v) const {
+        return sign == v.sign && a == v.a;
+    }
+    bool operator!=(const BinaryBigInt &v) const {
+        return !(*this == v);
+    }
+
+    // -------------------- Unary operator - and operators +- --------------------
+    BinaryBigInt operator-() const {
+        BinaryBigInt res = *this;
+        if (!isZero()) res.sign = -sign;
+        return res;
+    }
+
+    BinaryBigInt &operator+=(const BinaryBigInt &v) {
+        if (sign == v.sign) {
+            add_to(a, v.a);
+        } else if (compare(a, v.a) >= 0) {
+            sub_from(a, v.a);
+        } else {
+            Limbs r = v.a;
+            sub_from(r, a);
+            a.swap(r);
+            sign = v.sign;
+        }
+        trim();
+        return *this;
+    }
+    BinaryBigInt &operator-=(const BinaryBigInt &v) {
+        sign = -sign;
+        *this += v;
+        if (!isZero()) sign = -sign;
+        return *this;
+    }
+    friend BinaryBigInt operator+(BinaryBigInt l, const BinaryBigInt &r) {
+        l += r;
+        return l;
+    }
+    friend BinaryBigInt operator-(BinaryBigInt l, const BinaryBigInt &r) {
+        l -= r;
+        return l;
+    }
+
+    // -------------------- Operators * / % --------------------
+    void operator*=(int v) {
+        // |v| as unsigned, so that INT_MIN is not negated as an int.
+        unsigned m = v < 0 ? 0U - (unsigned) v : (unsigned) v;
+        if (v < 0)
+            sign = -sign;
+        Limb carry = 0;
+        for (Limb &x : a) {
+            Wide cur = (Wide) x * m + carry;
+            x = (Limb) cur;
+            carry = (Limb) (cur >> 64);
+        }
+        if (carry) a.push_back(carry);
+        trim();
+    }
+    BinaryBigInt operator*(int v) const {
+        BinaryBigInt res = *this;
+        res *= v;
+        return res;
+    }
+
+    BinaryBigInt operator*(const BinaryBigInt &v) const {
+        BinaryBigInt res;
+        res.a = multiply(a, v.a);
+        res.sign = sign * v.sign;
+        res.trim();
+        return res;
+    }
+    void operator*=(const BinaryBigInt &v) {
+        *this = *this * v;
+    }
+
+    // Same sign rules as divmod in bigint.h: the quotient is truncated and
+    // a negative remainder gets b added.
+    friend pair<BinaryBigInt, BinaryBigInt> divmod(const BinaryBigInt &a1,
+                                                   const BinaryBigInt &b1) {
+        pair<BinaryBigInt, BinaryBigInt> res;
+        divide(a1.a, b1.a, res.first.a, res.second.a);
+        res.first.sign = a1.sign * b1.sign;
+        res.second.sign = a1.sign;
+        res.first.trim();
+        res.second.trim();
+        if (res.second < 0) res.second += b1;
+        return res;
+    }
+    BinaryBigInt operator/(const BinaryBigInt &v) const {
+        return divmod(*this, v).first;
+    }
+    BinaryBigInt operator%(const BinaryBigInt &v) const {
+        return divmod(*this, v).second;
+    }
+    void operator/=(const BinaryBigInt &v) {
+        *this = *this / v;
+    }
+
+    void operator/=(int v) {
+        assert(v > 0); // operator / not well-defined for v <= 0.
+        divide_short(a, v);
+        trim();
+    }
+    BinaryBigInt operator/(int v) const {
+        BinaryBigInt res = *this;
+        res /= v;
+        return res;
+    }
+    long long operator%(long long v) const {
+        assert(v > 0); // operator % not well-defined for v <= 0.
+        Limb m = 0;
+        for (int i = (int) a.size() - 1; i >= 0; --i)
+            m = (Limb) ((((Wide) m << 64) | a[i]) % (Limb) v);
+        return (long long) m * sign;
+    }
+
+    // -------------------- Shifts --------------------
+    // Shift the magnitude, the sign stays: x >> k is x / 2^k truncated.
+    BinaryBigInt &operator<<=(int bits) {
+        shift_left(a, bits);
+        return *this;
+    }
+    BinaryBigInt &operator>>=(int bits) {
+        shift_right(a, bits);
+        trim();
+        return *this;
+    }
+    BinaryBigInt operator<<(int bits) const {
+        BinaryBigInt res = *this;
+        res <<= bits;
+        return res;
+    }
+    BinaryBigInt operator>>(int bits) const {
+        BinaryBigInt res = *this;
+        res >>= bits;
+        return res;
+    }
+
+    // -------------------- Misc --------------------
+    BinaryBigInt abs() const {
+        BinaryBigInt res = *this;
+        res.sign = 1;
+        return res;
+    }
+    void trim() {
+        while (!a.empty() && !a.back())
+            a.pop_back();
+        if (a.empty())
+            sign = 1;
+    }
+    bool isZero() const {
+        return a.empty();
+    }
+
+    // -------------------- Magnitudes --------------------
+    static void trim_limbs(Limbs &x) {
+        while (!x.empty() && !x.back())
+            x.pop_back();
+    }
+
+    static int compare(const Limbs &x, const Limbs &y) {
+        if (x.size() != y.size())
+            return x.size() < y.size() ? -1 : 1;
+        for (int i = (int) x.size() - 1; i >= 0; --i)
+            if (x[i] != y[i])
+                return x[i] < y[i] ? -1 : 1;
+        return 0;
+    }
+
+    // r[0 .. nr) += x[0 .. nx), returns the carry out of r.
+    static Limb add_limbs(Limb *r, int nr, const Limb *x, int nx) {
+        Limb carry = 0;
+        for (int i = 0; i < nr && (i < nx || carry); ++i) {
+            Limb s = r[i] + carry;
+            carry = s < carry;
+            if (i < nx) {
+                s += x[i];
+                carry += s < x[i];
+            }
+            r[i] = s;
+        }
+        return carry;
+    }
+
+    // r[0 .. nr) -= x[0 .. nx), returns the borrow out of r.
+    static Limb sub_limbs(Limb *r, int nr, const Limb *x, int nx) {
+        Limb borrow = 0;
+        for (int i = 0; i < nr && (i < nx || borrow); ++i) {
+            Limb d = i < nx ? x[i] : 0;
+            Limb s = r[i] - d - borrow;
+            borrow = r[i] < d || (r[i] == d && borrow);
+            r[i] = s;
+        }
+        return borrow;
+    }
+
+    static void add_to(Limbs &x, const Limbs &y) {
+        if (x.size() < y.size()) x.resize(y.size(), 0);
+        if (add_limbs(x.data(), (int) x.size(), y.data(), (int) y.size()))
+            x.push_back(1);
+    }
+    // x -= y for x >= y.
+    static void sub_from(Limbs &x, const Limbs &y) {
+        sub_limbs(x.data(), (int) x.size(), y.data(), (int) y.size());
+    }
+
+    // Limbs of scratch that multiply() needs below operands of up to n
+    // limbs: 2n + 8 for the sums and the middle product at each Karatsuba
+    // level, whose operands are at most n / 2 + 2 limbs long.
+    static int scratch_limbs(int n) {
+        int limbs = 0;
+        for (; n >= KARATSUBA_THRESHOLD; n = n / 2 + 2)
+            limbs += 2 * n + 8;
+        return limbs;
+    }
+
+    // res[0 .. nx + ny) = x * y, res must not overlap the operands.  All the
+    // Karatsuba levels below share scratch of scratch_limbs(max(nx, ny)).
+    static void multiply(const Limb *x, int nx, const Limb *y, int ny, Limb *res,
+                         Limb *scratch) {
+        if (nx < ny) swap(x, y), swap(nx, ny);
+        fill(res, res + nx + ny, 0ULL);
+        if (ny == 0) return;
+
+        if (ny >= NTT_THRESHOLD && 4LL * (nx + ny) <= (1LL << Transforms::MAX_LOG)) {
+            multiply_ntt(x, nx, y, ny, res);
+            return;
+        }
+
+        if (ny < KARATSUBA_THRESHOLD) {
+            for (int i = 0; i < ny; ++i) {
+                Limb carry = 0;
+                for (int j = 0; j < nx; ++j) {
+                    Wide cur = (Wide) y[i] * x[j] + res[i + j] + carry;
+                    res[i + j] = (Limb) cur;
+                    carry = (Limb) (cur >> 64);
+                }
+                res[i + nx] = carry;
+            }
+            return;
+        }
+
+        if (nx >= 2 * ny) {
+            // Unbalanced: x in pieces as long as y, each product in the
+            // scratch first.
+            Limb *part = scratch;
+            for (int i = 0; i < nx; i += ny) {
+                int ni = min(ny, nx - i);
+                multiply(x + i, ni, y, ny, part, scratch + 2 * ny);
+                add_limbs(res + i, nx + ny - i, part, ni + ny);
+            }
+            return;
+        }
+
+        // Karatsuba: x = x0 + x1 B^k, y = y0 + y1 B^k with k < ny <= nx.
+        int k = nx / 2;
+        multiply(x, k, y, k, res, scratch);
+        multiply(x + k, nx - k, y + k, ny - k, res + 2 * k, scratch);
+
+        Limb *sx = scratch;
+        int nsx = half_sum(x, k, nx, sx);
+        Limb *sy = sx + nsx;
+        int nsy = half_sum(y, k, ny, sy);
+        Limb *mid = sy + nsy;
+        int nm = nsx + nsy;
+        multiply(sx, nsx, sy, nsy, mid, mid + nm);
+        sub_limbs(mid, nm, res, 2 * k);
+        sub_limbs(mid, nm, res + 2 * k, nx + ny - 2 * k);
+        while (nm && !mid[nm - 1])
+            --nm;
+        add_limbs(res + k, nx + ny - k, mid, nm);
+    }
+
+    // s = x[0 .. k) + x[k .. n), one limb longer than the longer half;
+    // returns its length.
+    static int half_sum(const Limb *x, int k, int n, Limb *s) {
+        const Limb *lo = x, *hi = x + k;
+        int nlo = k, nhi = n - k;
+        if (nlo < nhi) swap(lo, hi), swap(nlo, nhi);
+        copy(lo, lo + nlo, s);
+        s[nlo] = add_limbs(s, nlo, hi, nhi);
+        return nlo + 1;
+    }
+
+    static Limbs multiply(const Limbs &x, const Limbs &y) {
+        if (x.empty() || y.empty()) return Limbs();
+        int nx = (int) x.size(), ny = (int) y.size();
+        Limbs res(nx + ny), scratch(scratch_limbs(max(nx, ny)));
+        multiply(x.data(), nx, y.data(), ny, res.data(), scratch.data());
+        trim_limbs(res);
+        return res;
+    }
+
+    // -------------------- Number-theoretic transform --------------------
+    // Limbs split into four 16-bit digits for Transforms' three-prime
+    // convolution (bigint.h).  A coefficient of the digit product is below
+    // 2^MAX_LOG * 2^32 < P1 * P2 * P3, so it comes out exact.
+    // res[0 .. nx + ny) = x * y.  Requires 4 * (nx + ny) <= 2^MAX_LOG.
+    static void multiply_ntt(const Limb *x, int nx, const Limb *y, int ny, Limb *res) {
+        const Wide P1 = Transforms::P1, P2 = Transforms::P2;
+        int n = 1;
+        while (n < 4 * (nx + ny))
+            n <<= 1;
+        auto digits = [n](const Limb *p, int np) {
+            vector<unsigned> d(n, 0);
+            for (int i = 0; i < 4 * np; ++i)
+                d[i] = (unsigned) (p[i / 4] >> (16 * (i % 4)) & 0xFFFF);
+            return d;
+        };
+        vector<unsigned> dx = digits(x, nx), dy;
+        bool square = x == y && nx == ny;
+        if (!square) dy = digits(y, ny);
+        const vector<unsigned> &other = square ? dx : dy;
+        vector<unsigned> f1, f2, f3;
+        Transforms::convolve_three(dx.data(), 4 * nx, other.data(), square ? 4 * nx : 4 * ny, n,
+                                   f1, f2, f3);
+
+        // c = v1 + P1 * (v2 + P2 * v3) < 2^84, carried 16 bits a digit.
+        Wide carry = 0;
+        for (int i = 0; i < 4 * (nx + ny); ++i) {
+            unsigned long long v2, v3;
+            Transforms::garner(f1[i], f2[i], f3[i], v2, v3);
+            carry += f1[i] + P1 * (v2 + P2 * v3);
+            if (i % 4 == 0) res[i / 4] = 0;
+            res[i / 4] |= (Limb) (carry & 0xFFFF) << (16 * (i % 4));
+            carry >>= 16;
+        }
+    }
+
+    static void shift_left(Limbs &x, int bits) {
+        if (x.empty()) return;
+        int limbs = bits / 64, s = bits % 64;
+        if (s) {
+            x.push_back(0);
+            for (int i = (int) x.size() - 1; i > 0; --i)
+                x[i] = x[i] << s | x[i - 1] >> (64 - s);
+            x[0] <<= s;
+            if (!x.back()) x.pop_back();
+        }
+        x.insert(x.begin(), limbs, 0ULL);
+    }
+
+    static void shift_right(Limbs &x, int bits) {
+        int limbs = bits / 64, s = bits % 64;
+        if (limbs >= (int) x.size()) {
+            x.clear();
+            return;
+        }
+        x.erase(x.begin(), x.begin() + limbs);
+        if (s) {
+            for (int i = 0; i + 1 < (int) x.size(); ++i)
+                x[i] = x[i] >> s | x[i + 1] << (64 - s);
+            x.back() >>= s;
+        }
+        trim_limbs(x);
+    }
+
+    // x /= v in place, returns the remainder.
+    static Limb divide_short(Limbs &x, Limb v) {
+        Limb rem = 0;
+        for (int i = (int) x.size() - 1; i >= 0; --i) {
+            Wide cur = (Wide) rem << 64 | x[i];
+            x[i] = (Limb) (cur / v);
+            rem = (Limb) (cur % v);
+        }
+        trim_limbs(x);
+        return rem;
+    }
+
+    // Knuth, TAOCP vol. 2, 4.3.1, Algorithm D on 64-bit limbs.
+    static void divide(const Limbs &u, const Limbs &v, Limbs &q, Limbs &r) {
+        if (compare(u, v) < 0) {
+            q.clear();
+            r = u;
+            return;
+        }
+        int n = (int) v.size(), m = (int) u.size() - n;
+        if (n == 1) {
+            q = u;
+            Limb rem = divide_short(q, v[0]);
+            r.assign(rem ? 1 : 0, rem);
+            return;
+        }
+
+        // D1: normalize so that the top limb of the divisor has its high bit.
+        int s = __builtin_clzll(v.back());
+        Limbs vn = v, un = u;
+        un.push_back(0);
+        shift_left(vn, s);
+        if (s) {
+            for (int i = (int) un.size() - 1; i > 0; --i)
+                un[i] = un[i] << s | un[i - 1] >> (64 - s);
+            un[0] <<= s;
+        }
+
+        q.assign(m + 1, 0);
+        for (int j = m; j >= 0; --j) {
+            // D3: estimate, at most two too large after the correction.
+            Wide num = (Wide) un[j + n] << 64 | un[j + n - 1];
+            Wide qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+            while (qhat >> 64 || qhat * vn[n - 2] > (rhat << 64 | un[j + n - 2])) {
+                --qhat;
+                rhat += vn[n - 1];
+                if (rhat >> 64) break;
+            }
+
+            // D4: un[j .. j + n] -= qhat * vn.
+            Limb carry = 0, borrow = 0;
+            for (int i = 0; i <= n; ++i) {
+                Wide p = i < n ? qhat * vn[i] + carry : carry;
+                carry = (Limb) (p >> 64);
+                Limb lo = (Limb) p, x = un[i + j];
+                un[i + j] = x - lo - borrow;
+                borrow = x < lo || (x == lo && borrow);
+            }
+
+            // D6: rare add back.
+            if (borrow) {
+                --qhat;
+                add_limbs(un.data() + j, n + 1, vn.data(), n);
+            }
+            q[j] = (Limb) qhat;
+        }
+        trim_limbs(q);
+
+        un.resize(n);
+        shift_right(un, s);
+        r = un;
+    }
+
+    // -------------------- Newton division --------------------
+    // 2^(128 m) / y for positive y of m limbs, off by at most a few units; as
+    // BigInt::reciprocal (bigint.h), on signed values since the error term
+    // of a step can be negative.
+    static BinaryBigInt reciprocal(const BinaryBigInt &y) {
+        int m = (int) y.a.size();
+        if (m < NEWTON_THRESHOLD) {
+            BinaryBigInt one = 1, res, rem;
+            divide((one << 128 * m).a, y.a, res.a, rem.a);
+            return res;
+        }
+
+        // xh ~ 2^(128 h) / yh for the top h limbs yh of y; one Newton step
+        // x += x * (2^(128 m) - y * x) / 2^(128 m) with x = xh * 2^(64 (m - h))
+        // makes it good to the whole m + 1 limbs.
+        int h = m / 2 + 2;
+        BinaryBigInt xh = reciprocal(y >> 64 * (m - h));
+        BinaryBigInt e = (BinaryBigInt(1) << 64 * (m + h)) - y * xh;
+        return (xh << 64 * (m - h)) + (xh * e >> 128 * h);
+    }
+
+    // hi = x / p, lo = x % p for 0 <= x < 2^(128 m), where p has m limbs and
+    // inv = reciprocal(p): one product for the quotient, a couple of units
+    // of correction.
+    static void divide_reciprocal(const Limbs &x, const BinaryBigInt &p,
+                                  const BinaryBigInt &inv, Limbs &hi, Limbs &lo) {
+        int m = (int) p.a.size();
+        BinaryBigInt u;
+        u.a = x;
+        BinaryBigInt q = (u >> 64 * (m - 1)) * inv >> 64 * (m + 1);
+        BinaryBigInt r = u - q * p;
+        while (r < 0) {
+            r += p, q -= 1;
+        }
+        while (r >= p) {
+            r -= p, q += 1;
+        }
+        hi.swap(q.a);
+        lo.swap(r.a);
+    }
+
+    // -------------------- Decimal conversion --------------------
+    // 10^(LIMB_DIGITS * 2^k), each the square of the previous one.  Shared
+    // between threads, entries are never modified once published.
+    static shared_ptr<const Limbs> power_of_ten(int k) {
+        static mutex powers_mutex;
+        static vector<shared_ptr<const Limbs> > powers;
+        lock_guard<mutex> lock(powers_mutex);
+        if (powers.empty()) {
+            Limb first = LIMB_TEN_POWER;
+            powers.push_back(make_shared<const Limbs>(1, first));
+        }
+        while ((int) powers.size() <= k)
+            powers.push_back(
+                make_shared<const Limbs>(multiply(*powers.back(), *powers.back())));
+        return powers[k];
+    }
+
+    // reciprocal(power_of_ten(k)), made on first use and kept like the power.
+    static shared_ptr<const BinaryBigInt> power_of_ten_reciprocal(int k) {
+        static mutex reciprocals_mutex;
+        static vector<shared_ptr<const BinaryBigInt> > reciprocals;
+        shared_ptr<const Limbs> power = power_of_ten(k);
+        lock_guard<mutex> lock(reciprocals_mutex);
+        if ((int) reciprocals.size() <= k) reciprocals.resize(k + 1);
+        if (!reciprocals[k]) {
+            BinaryBigInt p;
+            p.a = *power;
+            reciprocals[k] = make_shared<const BinaryBigInt>(reciprocal(p));
+        }
+        return reciprocals[k];
+    }
+
+    // Appends x < 10^(LIMB_DIGITS * 2^(k + 1)); pad asks for all the digits
+    // with leading zeros, as the lower half of a split needs.
+    static void write_decimal(const Limbs &x, int k, bool pad, string &out) {
+        if ((int) x.size() <= DECIMAL_THRESHOLD) {
+            // Chunks of LIMB_DIGITS digits, least significant first.
+            Limbs rest = x;
+            vector<Limb> chunks;
+            while (!rest.empty())
+                chunks.push_back(divide_short(rest, LIMB_TEN_POWER));
+            int width = pad ? LIMB_DIGITS << (k + 1) : 0;
+            string digits;
+            for (int i = (int) chunks.size() - 1; i >= 0; --i) {
+                string chunk = std::to_string(chunks[i]);
+                if (i + 1 < (int) chunks.size())
+                    digits.append(LIMB_DIGITS - chunk.size(), '0');
+                digits += chunk;
+            }
+            if (chunks.empty() && !pad)
+                digits = "0";
+            out.append(max(0, width - (int) digits.size()), '0');
+            out += digits;
+            return;
+        }
+        Limbs hi, lo;
+        shared_ptr<const Limbs> power = power_of_ten(k);
+        if ((int) power->size() >= NEWTON_THRESHOLD) {
+            BinaryBigInt p;
+            p.a = *power;
+            divide_reciprocal(x, p, *power_of_ten_reciprocal(k), hi, lo);
+        } else {
+            divide(x, *power, hi, lo);
+        }
+        if (pad || !hi.empty()) {
+            write_decimal(hi, k - 1, pad, out);
+            write_decimal(lo, k - 1, true, out);
+        } else {
+            write_decimal(lo, k - 1, false, out);
+        }
+    }
+
+    // The value of the decimal digits s[0 .. len): the high part times a
+    // cached power of ten plus the low part, both converted recursively.
+    static Limbs from_decimal(const char *s, int len) {
+        if (len <= LIMB_DIGITS * DECIMAL_THRESHOLD) {
+            // Horner over chunks of LIMB_DIGITS digits.
+            Limbs res;
+            for (int i = 0; i < len;) {
+                int take = (len - i - 1) % LIMB_DIGITS + 1;
+                Limb chunk = 0, scale = 1;
+                for (int j = 0; j < take; ++j, ++i)
+                    chunk = chunk * 10 + (s[i] - '0'), scale *= 10;
+                Limb carry = chunk;
+                for (Limb &x : res) {
+                    Wide cur = (Wide) x * scale + carry;
+                    x = (Limb) cur;
+                    carry = (Limb) (cur >> 64);
+                }
+                if (carry) res.push_back(carry);
+            }
+            return res;
+        }
+        int k = 0;
+        while ((long long) LIMB_DIGITS << (k + 1) < len)
+            ++k;
+        int low = LIMB_DIGITS << k;
+        Limbs res = multiply(from_decimal(s, len - low), *power_of_ten(k));
+        add_to(res, from_decimal(s + len - low, low));
+        return res;
+    }
+};
@@ -0,0 +1,269 @@
+// Калькулятор методом рекурсивного спуска, см. calc.cpp.
+// Перед включением нужны bigint.h, string.h и iterator.
+#include "bigint_accumulator.h"
+#include "bigint_arena.h"
+#include "bigint_tree.h"
+
+class CSyntaxError {};
+class CDivisionByZero {};
+
+// Чем копить сумму слагаемых: для BigInt — аккумулятор с отложенными
+// переносами (bigint_accumulator.h), для остальных типов — само число.
+template <typename Int> struct CSumOf {
+    typedef Int type;
+};
+template <> struct CSumOf<BigInt> {
+    typedef BigIntAccumulator type;
+};
+
+// Арена по умолчанию: лимбы из LimbResource берет только BigInt, остальным
+// типам она ни к чему.
+template <typename Int> struct CDefaultArena {
+    static const size_t size = 0;
+};
+template <> struct CDefaultArena<BigInt> {
+    static const size_t size = 1 << 22;
+};
+
+// Int — тип чисел: BigInt из bigint.h, BinaryBigInt из binary_bigint.h или
+// FixedBigInt<Bits> из fixed_bigint.h (тогда переполнение бросает
+// FixedBigIntOverflow), от него нужны конструктор из long long, += -= *= /= и сравнение.
+template <typename Int> class CBasicCalculator {
+
+  public:
+    // arena_size — арена под промежуточные числа одного выражения,
+    // 0 — обходимся обычной кучей.
+    explicit CBasicCalculator(size_t arena_size = CDefaultArena<Int>::size)
+        : arena(arena_size) {}
+
+    // Основной интерфейс.
+    Int process(const char *input_expression) {
+        if (!input_expression) {
+            throw(CSyntaxError());
+        }
+        // Все временные числа выражения берут лимбы из арены, а она
+        // сбрасывается разом на выходе, даже если вылетело исключение.
+        ArenaReset reset(*this);
+        Int value;
+        {
+            LimbResourceScope scope(arena.resource());
+            number = 0;
+            token_type = UNDEF;
+            expression = input_expression;
+            pos = 0;
+
+            value = process_low_precendence();
+        }
+        // Результат переживает арену, поэтому копируем его в обычную кучу.
+        Int result = value;
+        return result;
+    }
+
+    // Публичный getter, чтобы знать, где произошла ошибка разбора
+    int get_pos() {
+        return pos;
+    };
+
+  private:
+    enum TOKENTYPE {
+        UNDEF = 0,
+        EOL = '\0',
+        NUMBER = 1,
+        ADD = '+',
+        SUB = '-',
+        MUL = '*',
+        DIV = '/'
+    };
+
+    // в процессе парсинга значения числовых литералов
+    Int number;
+
+    // Первые DIRECT_FACTORS множителей цепочки перемножаем сразу: на коротких
+    // цепочках дерево ничего не выигрывает, а вектор стоил бы похода в кучу.
+    static const int DIRECT_FACTORS = 8;
+
+    // Остальные множители длинной цепочки, для дерева. Буфер живет между
+    // вызовами, сами числа — из арены.
+    vector<Int> factors;
+
+    BigIntArena arena;
+
+    // Отдает арене все, что в ней осталось: number и factors — единственные
+    // числа, которые могут пережить вызов process().
+    struct ArenaReset {
+        CBasicCalculator &calculator;
+        explicit ArenaReset(CBasicCalculator &c) : calculator(c) {}
+        ~ArenaReset() {
+            calculator.number = Int();
+            calculator.factors.clear();
+            calculator.arena.reset();
+        }
+    };
+
+    // Текущая позиция в разборе
+    int pos;
+
+    const char *expression;
+    TOKENTYPE token_type;
+
+    // Слагаемые копятся в sum, переносы (для BigInt) разносятся один раз
+    // в конце. Лимбы sum, как и у чисел, берутся из арены.
+    Int process_low_precendence() {
+        typename CSumOf<Int>::type sum(process_high_precendence());
+
+        while (1) {
+            switch (next_token()) {
+            case '+':
+                sum += process_high_precendence();
+                break;
+            case '-':
+                sum -= process_high_precendence();
+                break;
+            case EOL:
+                return value_of(sum);
+            default:
+                throw(CSyntaxError());
+            }
+        }
+        return 0;
+    }
+
+    // Длинную цепочку множителей до очередного '/' перемножаем деревом
+    // (product из bigint_tree.h), а не слева направо: иначе растущее
+    // произведение каждый раз умножается на короткое число.
+    Int process_high_precendence() {
+        Int term = process_number();
+        // Множителей в term с начала цепочки.
+        int chain = 1;
+        Int divisor;
+        while (1) {
+            switch (TOKENTYPE token = next_token()) {
+            case '*':
+                if (chain < DIRECT_FACTORS) {
+                    term *= process_number();
+                    ++chain;
+                } else {
+                    factors.push_back(process_number());
+                }
+                break;
+            case '/':
+                divisor = process_number();
+                if (Int(0) == divisor) {
+                    throw(CDivisionByZero());
+                }
+                multiply_factors(term);
+                term /= divisor;
+                chain = 1;
+                break;
+            default:
+                // возвращаемся с к низкоприоритетным.
+                token_type = token;
+                multiply_factors(term);
+                return term;
+            }
+        }
+
+        return 0;
+    }
+
+    static Int value_of(const Int &x) {
+        return x;
+    }
+    static BigInt value_of(BigIntAccumulator &x) {
+        return x.value();
+    }
+
+    // Литерал с позиции pos. BigInt собирает лимбы прямо из цифр через
+    // BigInt::DecimalReader — один линейный проход.
+    void read_number(BigInt &x) {
+        BigInt::DecimalReader reader(x);
+        pos += reader.feed(expression + pos, strspn(expression + pos, "0123456789"));
+        reader.finish();
+    }
+    // Остальные типы — по схеме Горнера, по восемь цифр за умножение:
+    // для длинных литералов это по-прежнему квадратично, только в восемь
+    // раз меньше проходов по числу.
+    template <typename T> void read_number(T &x) {
+        x = 0;
+        int digit = expression[pos] - '0';
+        do {
+            int chunk = 0, scale = 1;
+            for (int k = 0; k < 8 && 0 <= digit && digit <= 9; ++k) {
+                chunk = chunk * 10 + digit;
+                scale *= 10;
+                digit = expression[++pos] - '0';
+            }
+            x *= scale;
+            x += chunk;
+        } while (0 <= digit && digit <= 9);
+    }
+
+    // Домножает term на отложенные множители цепочки.
+    void multiply_factors(Int &term) {
+        if (factors.empty()) return;
+        term *= product(make_move_iterator(factors.begin()),
+                        make_move_iterator(factors.end()));
+        factors.clear();
+    }
+
+    // Обработка числовых литералов
+    Int process_number() {
+        switch (next_token()) {
+        case SUB:
+            // поехали дальше за числом
+            eat_number();
+            return -number;
+        case NUMBER:
+            return number;
+        }
+        throw(CSyntaxError());
+    }
+
+    // Ожидаем именно численный литерал без знака
+    void eat_number() {
+        if (next_token() != NUMBER) throw(CSyntaxError());
+    }
+
+    // Следующий токен
+    // возвращаем тип, число грузит в number.
+    TOKENTYPE next_token() {
+        // Если еще необработанный токен в «очереди» — выдаем его.
+        if (token_type != UNDEF) {
+            TOKENTYPE tmp = token_type;
+            token_type = UNDEF;
+            return tmp;
+        }
+
+        char ch = expression[pos];
+
+        // Eating space
+        while (ch == ' ') {
+            ch = expression[++pos];
+        }
+
+        // Если число - забираем.
+        int digitmaybe = ch - '0';
+        if (0 <= digitmaybe && digitmaybe <= 9) {
+            // Число.
+            read_number(number);
+            return NUMBER;
+        }
+
+        // Выделяем допустимые операции
+        switch (ch) {
+        case '\0':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+            // За концом строки не шагаем; strlen тут сделал бы длинные
+            // выражения квадратичными.
+            if (ch != '\0') pos++;
+            return static_cast<TOKENTYPE>(ch);
+        default:
+            throw(CSyntaxError());
+        }
+    }
+};
+
+typedef CBasicCalculator<BigInt> CCalculator;
@@ -0,0 +1,332 @@
+#pragma once
+// FixedBigInt<Bits>: a signed integer of exactly Bits bits with the
+// operators of BigInt (bigint.h), for values of known bounded width.
+//
+// Two's complement in Bits / 64 words held by value: no heap, no limb
+// vector, no sign-magnitude branches in + and -.  Addition, subtraction,
+// negation and comparison loop over a compile-time count, which the compiler
+// unrolls; * and / skip the zero high words of short values.  A result that does not
+// fit, a literal included, throws FixedBigIntOverflow instead of wrapping
+// around.  Everything but string conversion is constexpr.  Division and
+// remainder follow BigInt: the quotient is truncated, a negative remainder
+// gets the divisor added.
+//
+// Before including this header one needs <string>, <iostream> and
+// 'using namespace std', as for bigint.h.
+
+class FixedBigIntOverflow {};
+
+template <int Bits> struct FixedBigInt {
+    static_assert(Bits > 0 && Bits % 64 == 0, "FixedBigInt: Bits must be a multiple of 64");
+
+    typedef unsigned long long Limb;
+    typedef unsigned __int128 Wide;
+    static const int N = Bits / 64;
+
+    Limb a[N] = {}; // two's complement, least significant word first
+
+    // -------------------- Constructors --------------------
+    constexpr FixedBigInt() {}
+
+    constexpr FixedBigInt(long long v) {
+        a[0] = (Limb) v;
+        for (int i = 1; i < N; ++i)
+            a[i] = v < 0 ? ~0ULL : 0;
+    }
+
+    FixedBigInt(const string &s) {
+        read(s);
+    }
+
+    static constexpr FixedBigInt max() {
+        FixedBigInt res;
+        for (int i = 0; i < N; ++i)
+            res.a[i] = ~0ULL;
+        res.a[N - 1] >>= 1;
+        return res;
+    }
+    static constexpr FixedBigInt min() {
+        FixedBigInt res;
+        res.a[N - 1] = 1ULL << 63;
+        return res;
+    }
+
+    // -------------------- Input / Output --------------------
+    // Digit by digit: the length is bounded, and so is the cost.
+    void read(const string &s) {
+        int pos = 0;
+        bool minus = false;
+        while (pos < (int) s.size() && (s[pos] == '-' || s[pos] == '+')) {
+            if (s[pos] == '-')
+                minus = !minus;
+            ++pos;
+        }
+        // Accumulate negatively, so that min() reads as well.
+        FixedBigInt res;
+        for (; pos < (int) s.size(); ++pos) {
+            res *= 10;
+            res -= s[pos] - '0';
+        }
+        *this = minus ? res : -res;
+    }
+    friend istream &operator>>(istream &stream, FixedBigInt &v) {
+        string s;
+        stream >> s;
+        v.read(s);
+        return stream;
+    }
+
+    // Nineteen digits per division by 10^19.
+    friend ostream &operator<<(ostream &stream, const FixedBigInt &v) {
+        Limb m[N];
+        v.magnitude(m);
+        string out;
+        do {
+            Limb rem = div_small(m, 10000000000000000000ULL);
+            for (int i = 0; i < 19; ++i, rem /= 10)
+                out += char('0' + rem % 10);
+        } while (!is_zero(m));
+        while (out.size() > 1 && out.back() == '0')
+            out.pop_back();
+        if (v.negative())
+            out += '-';
+        return stream << string(out.rbegin(), out.rend());
+    }
+
+    // -------------------- Comparison --------------------
+    friend constexpr bool operator<(const FixedBigInt &l, const FixedBigInt &r) {
+        if (l.negative() != r.negative())
+            return l.negative();
+        return compare(l.a, r.a) < 0;
+    }
+    friend constexpr bool operator>(const FixedBigInt &l, const FixedBigInt &r) {
+        return r < l;
+    }
+    friend constexpr bool operator<=(const FixedBigInt &l, const FixedBigInt &r) {
+        return !(r < l);
+    }
+    friend constexpr bool operator>=(const FixedBigInt &l, const FixedBigInt &r) {
+        return !(l < r);
+    }
+    friend constexpr bool operator==(const FixedBigInt &l, const FixedBigInt &r) {
+        return compare(l.a, r.a) == 0;
+    }
+    friend constexpr bool operator!=(const FixedBigInt &l, const FixedBigInt &r) {
+        return compare(l.a, r.a) != 0;
+    }
+
+    // -------------------- Unary operator - and operators +- --------------------
+    constexpr FixedBigInt operator-() const {
+        if (*this == min()) throw FixedBigIntOverflow();
+        FixedBigInt res = *this;
+        negate(res.a);
+        return res;
+    }
+
+    // Signed overflow: both operands of one sign, the sum of the other.
+    constexpr FixedBigInt &operator+=(const FixedBigInt &v) {
+        bool sa = negative(), sv = v.negative();
+        Limb carry = 0;
+        for (int i = 0; i < N; ++i) {
+            Wide cur = (Wide) a[i] + v.a[i] + carry;
+            a[i] = (Limb) cur;
+            carry = (Limb) (cur >> 64);
+        }
+        if (sa == sv && negative() != sa) throw FixedBigIntOverflow();
+        return *this;
+    }
+    constexpr FixedBigInt &operator-=(const FixedBigInt &v) {
+        bool sa = negative(), sv = v.negative();
+        Limb borrow = 0;
+        for (int i = 0; i < N; ++i) {
+            Limb d = a[i] - v.a[i] - borrow;
+            borrow = a[i] < v.a[i] || (a[i] == v.a[i] && borrow);
+            a[i] = d;
+        }
+        if (sa != sv && negative() != sa) throw FixedBigIntOverflow();
+        return *this;
+    }
+    friend constexpr FixedBigInt operator+(FixedBigInt l, const FixedBigInt &r) {
+        return l += r;
+    }
+    friend constexpr FixedBigInt operator-(FixedBigInt l, const FixedBigInt &r) {
+        return l -= r;
+    }
+
+    // -------------------- Operators * / % --------------------
+    // Schoolbook on magnitudes over their significant words; a product word
+    // past N or a carry out of the top one is an overflow.
+    constexpr FixedBigInt &operator*=(const FixedBigInt &v) {
+        bool minus = negative() != v.negative();
+        Limb x[N] = {}, y[N] = {}, res[N] = {};
+        magnitude(x);
+        v.magnitude(y);
+        int nx = significant(x), ny = significant(y);
+        if (nx && ny && nx + ny - 1 > N) throw FixedBigIntOverflow();
+        for (int i = 0; i < nx; ++i) {
+            Limb carry = 0;
+            for (int j = 0; j < ny; ++j) {
+                Wide cur = (Wide) x[i] * y[j] + res[i + j] + carry;
+                res[i + j] = (Limb) cur;
+                carry = (Limb) (cur >> 64);
+            }
+            if (i + ny < N) {
+                res[i + ny] = carry;
+            } else if (carry) {
+                throw FixedBigIntOverflow();
+            }
+        }
+        set_signed(res, minus);
+        return *this;
+    }
+    friend constexpr FixedBigInt operator*(FixedBigInt l, const FixedBigInt &r) {
+        return l *= r;
+    }
+
+    constexpr FixedBigInt &operator/=(const FixedBigInt &v) {
+        return *this = *this / v;
+    }
+    constexpr FixedBigInt &operator%=(const FixedBigInt &v) {
+        return *this = *this % v;
+    }
+
+    // The quotient is truncated; only min() / -1 does not fit.
+    friend constexpr FixedBigInt operator/(const FixedBigInt &l, const FixedBigInt &r) {
+        Limb q[N] = {}, rem[N] = {};
+        divmod_magnitudes(l, r, q, rem);
+        FixedBigInt res;
+        res.set_signed(q, l.negative() != r.negative());
+        return res;
+    }
+    // The sign of l, then r added to a negative remainder, as BigInt does.
+    friend constexpr FixedBigInt operator%(const FixedBigInt &l, const FixedBigInt &r) {
+        Limb q[N] = {}, rem[N] = {};
+        divmod_magnitudes(l, r, q, rem);
+        FixedBigInt res;
+        res.set_signed(rem, l.negative());
+        if (res.negative()) res += r;
+        return res;
+    }
+    friend constexpr pair<FixedBigInt, FixedBigInt> divmod(const FixedBigInt &l,
+                                                            const FixedBigInt &r) {
+        return make_pair(l / r, l % r);
+    }
+
+    // -------------------- Misc --------------------
+    constexpr FixedBigInt abs() const {
+        return negative() ? -*this : *this;
+    }
+
+    constexpr bool isZero() const {
+        return is_zero(a);
+    }
+
+    constexpr bool negative() const {
+        return a[N - 1] >> 63;
+    }
+
+  private:
+    // |l| = q * |r| + rem: one word at a time when |r| fits in one, bit by
+    // bit over the significant bits of |l| otherwise.
+    static constexpr void divmod_magnitudes(const FixedBigInt &l, const FixedBigInt &r,
+                                            Limb (&q)[N], Limb (&rem)[N]) {
+        assert(!r.isZero());
+        Limb y[N] = {};
+        l.magnitude(q);
+        r.magnitude(y);
+        if (significant(y) == 1) {
+            rem[0] = div_small(q, y[0]);
+            return;
+        }
+        for (int bit = significant(q) * 64 - 1; bit >= 0; --bit) {
+            shift_left_one(rem, q[bit / 64] >> (bit % 64) & 1);
+            q[bit / 64] &= ~(1ULL << (bit % 64));
+            if (compare(rem, y) >= 0) {
+                sub(rem, y);
+                q[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
+    }
+
+    // |*this| as an unsigned number; the magnitude of min() still fits.
+    constexpr void magnitude(Limb (&m)[N]) const {
+        for (int i = 0; i < N; ++i)
+            m[i] = a[i];
+        if (negative()) negate(m);
+    }
+
+    // *this = -m when minus, m otherwise, if that fits in Bits signed bits.
+    constexpr void set_signed(Limb (&m)[N], bool minus) {
+        if (m[N - 1] >> 63) {
+            bool only_top = m[N - 1] == 1ULL << 63;
+            for (int i = 0; i < N - 1; ++i)
+                only_top = only_top && !m[i];
+            if (!minus || !only_top) throw FixedBigIntOverflow();
+        }
+        if (minus) negate(m);
+        for (int i = 0; i < N; ++i)
+            a[i] = m[i];
+    }
+
+    static constexpr void negate(Limb (&m)[N]) {
+        Limb carry = 1;
+        for (int i = 0; i < N; ++i) {
+            m[i] = ~m[i] + carry;
+            carry = carry && !m[i];
+        }
+    }
+
+    static constexpr int compare(const Limb (&x)[N], const Limb (&y)[N]) {
+        for (int i = N - 1; i >= 0; --i)
+            if (x[i] != y[i])
+                return x[i] < y[i] ? -1 : 1;
+        return 0;
+    }
+
+    static constexpr bool is_zero(const Limb (&m)[N]) {
+        for (int i = 0; i < N; ++i)
+            if (m[i]) return false;
+        return true;
+    }
+
+    // Words up to the highest non-zero one.
+    static constexpr int significant(const Limb (&m)[N]) {
+        int n = N;
+        while (n > 0 && !m[n - 1])
+            --n;
+        return n;
+    }
+
+    // m /= d, returns m % d.  While the running remainder is zero a word
+    // takes the plain 64-bit division.
+    static constexpr Limb div_small(Limb (&m)[N], Limb d) {
+        Limb rem = 0;
+        for (int i = significant(m) - 1; i >= 0; --i) {
+            if (!rem) {
+                rem = m[i] % d;
+                m[i] /= d;
+            } else {
+                Wide cur = (Wide) rem << 64 | m[i];
+                m[i] = (Limb) (cur / d);
+                rem = (Limb) (cur % d);
+            }
+        }
+        return rem;
+    }
+
+    static constexpr void shift_left_one(Limb (&m)[N], Limb low) {
+        for (int i = N - 1; i > 0; --i)
+            m[i] = m[i] << 1 | m[i - 1] >> 63;
+        m[0] = m[0] << 1 | low;
+    }
+
+    // x -= y for x >= y.
+    static constexpr void sub(Limb (&x)[N], const Limb (&y)[N]) {
+        Limb borrow = 0;
+        for (int i = 0; i < N; ++i) {
+            Limb d = x[i] - y[i] - borrow;
+            borrow = x[i] < y[i] || (x[i] == y[i] && borrow);
+            x[i] = d;
+        }
+    }
+};
@@ -0,0 +1,1165 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <complex>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+#include "bigint.h"
+#include "bigint_accumulator.h"
+#include "bigint_divisor.h"
+#include "bigint_modulus.h"
+#include "bigint_serialize.h"
+#include "bigint_tree.h"
+#include "binary_bigint.h"
+#include "fixed_bigint.h"
+#include "calculator.h"
+
+// Свежие glibc объявляют SIGSTKSZ не константой, а этот catch.hpp про это
+// еще не знает — обработчики сигналов нам для тестов не нужны.
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+// Юнит-тесты самой длинной арифметики. Калькулятор целиком проверяет
+// test.py, а здесь гоняем то, до чего через командную строку не достать.
+
+// Случайное число из n лимбов с ненулевым старшим.
+static BigInt random_bigint(int n, mt19937 &gen) {
+    BigInt x;
+    x.a.resize(n);
+    for (int i = 0; i < n; ++i) x.a[i] = gen() % BASE;
+    if (n) x.a.back() = 1 + gen() % (BASE - 1);
+    return x;
+}
+
+template <typename Int> static string to_string(const Int &x) {
+    ostringstream out;
+    out << x;
+    return out.str();
+}
+
+TEST_CASE("NTT умножение совпадает со школьным", "[mul]") {
+    mt19937 gen(2019);
+    for (int n : {1, 2, 3, 17, 100, 257, 1000}) {
+        for (int m : {1, 5, 256, 700}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            if (gen() & 1) x = -x;
+            REQUIRE(x.mul_ntt(y) == x.mul_simple(y));
+        }
+    }
+    SECTION("ноль") {
+        BigInt x = random_bigint(300, gen);
+        REQUIRE(x.mul_ntt(BigInt(0)).isZero());
+        REQUIRE(BigInt(0).mul_ntt(x).isZero());
+    }
+}
+
+TEST_CASE("FFT умножение двух разных чисел совпадает с NTT", "[mul]") {
+    mt19937 gen(2036);
+    // Вещественные части — одно число, мнимые — другое: проверяем, что
+    // множители не путаются, и на разных длинах.
+    for (int n : {1, 2, 9, 100, 333, 1000, 5000}) {
+        for (int m : {1, 3, 64, 777, 4000}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            if (gen() & 1) y = -y;
+            BigInt expected = n * m <= 100000 ? x.mul_simple(y) : x.mul_ntt(y);
+            REQUIRE(x.mul_fft(y) == expected);
+            REQUIRE(y.mul_fft(x) == expected);
+        }
+    }
+    SECTION("все лимбы максимальные") {
+        // Самые большие коэффициенты свертки — самые большие ошибки округления.
+        for (int n : {1, 50, 1000, 20000}) {
+            for (int m : {1, 7, 1000, 15000}) {
+                BigInt x(string(9 * n, '9')), y(string(9 * m, '9'));
+                REQUIRE(x.mul_fft(y) == x.mul_ntt(y));
+            }
+        }
+    }
+}
+
+TEST_CASE("Длинное на короткое по кускам", "[mul]") {
+    mt19937 gen(2035);
+    for (int m : {1, 7, 300, 500}) {
+        for (int n : {m, 2 * m, 5 * m + 3, 3000}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            if (gen() & 1) y = -y;
+            BigInt expected = x.mul_simple(y);
+            REQUIRE(x.mul_unbalanced(y) == expected);
+            REQUIRE(y.mul_unbalanced(x) == expected);
+            REQUIRE(x * y == expected);
+        }
+    }
+    // Переносы из кусков бегут далеко: 99...9 * 99...9.
+    BigInt nines(string(9 * 2000, '9')), short_nines(string(9 * 300, '9'));
+    REQUIRE(nines.mul_unbalanced(short_nines) == nines.mul_simple(short_nines));
+    REQUIRE(nines.mul_unbalanced(BigInt()).isZero());
+}
+
+TEST_CASE("Карацуба на общем рабочем буфере совпадает со школьным", "[mul]") {
+    mt19937 gen(2024);
+    for (int n : {1, 6, 11, 64, 65, 300}) {
+        for (int m : {1, 11, 64, 299}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            if (gen() & 1) x = -x;
+            REQUIRE(x.mul_karatsuba(y) == x.mul_simple(y));
+        }
+    }
+    BigInt nines(string(9 * 500, '9'));
+    REQUIRE(nines.mul_karatsuba(nines) == nines.mul_simple(nines));
+    REQUIRE(BigInt(0).mul_karatsuba(nines).isZero());
+}
+
+TEST_CASE("Toom-3 и Toom-4 совпадают со школьным умножением", "[mul]") {
+    mt19937 gen(2023);
+    for (int k : {3, 4}) {
+        for (int n : {1, 2, 5, 12, 100, 301}) {
+            for (int m : {1, 7, 100, 290}) {
+                BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+                if (gen() & 1) y = -y;
+                REQUIRE(x.mul_toom(y, k) == x.mul_simple(y));
+            }
+        }
+    }
+    SECTION("все лимбы максимальные") {
+        BigInt nines(string(9 * 200, '9'));
+        REQUIRE(nines.mul_toom(nines, 3) == nines.mul_simple(nines));
+        REQUIRE(nines.mul_toom(nines, 4) == nines.mul_simple(nines));
+    }
+}
+
+TEST_CASE("Квадрат на каждом уровне совпадает с умножением копии", "[mul]") {
+    mt19937 gen(2025);
+    for (int n : {1, 2, 9, 33, 64, 130, 700}) {
+        BigInt x = random_bigint(n, gen);
+        if (gen() & 1) x = -x;
+        BigInt y = x;
+        BigInt expected = x.mul_simple(y);
+        REQUIRE(x.mul_simple(x) == expected);
+        REQUIRE(x.mul_karatsuba(x) == expected);
+        REQUIRE(x.mul_toom(x, 3) == expected);
+        REQUIRE(x.mul_toom(x, 4) == expected);
+        REQUIRE(x.mul_ntt(x) == expected);
+        REQUIRE(x.mul_fft(x) == expected);
+        REQUIRE(x * x == expected);
+        x *= x;
+        REQUIRE(x == expected);
+    }
+    SECTION("степень") {
+        REQUIRE(pow(BigInt(0), 0) == 1);
+        REQUIRE(pow(BigInt(-3), 3) == -27);
+        REQUIRE(to_string(pow(BigInt(2), 100)) == "1267650600228229401496703205376");
+        BigInt x = random_bigint(20, gen), expected = 1;
+        for (int i = 0; i < 37; ++i) expected = expected.mul_simple(x);
+        REQUIRE(pow(x, 37) == expected);
+    }
+}
+
+TEST_CASE("Многопоточное умножение дает тот же результат", "[mul][threads]") {
+    mt19937 gen(2026);
+    // Преобразования на 2^16 точек и больше: NTT раздает простые по потокам,
+    // а при восьми потоках и FFT, и NTT делят еще и этапы бабочек — на каждый
+    // поток приходится не меньше MIN_PER_THREAD бабочек.
+    BigInt x = random_bigint(20000, gen), y = random_bigint(15000, gen);
+    BigInt karatsuba = x.mul_karatsuba(y), ntt = x.mul_ntt(y), fft = x.mul_fft(y);
+    BigInt square = x.mul_karatsuba(x);
+    REQUIRE(karatsuba == ntt);
+    REQUIRE(square == x.mul_ntt(x));
+    for (int threads : {2, 3, 8}) {
+        BigInt::mul_threads() = threads;
+        REQUIRE(x.mul_karatsuba(y) == karatsuba);
+        REQUIRE(x.mul_karatsuba(x) == square);
+        REQUIRE(x.mul_ntt(y) == ntt);
+        REQUIRE(x.mul_fft(y) == fft);
+    }
+    BigInt::mul_threads() = 1;
+}
+
+TEST_CASE("Кэш таблиц преобразований ограничен по памяти", "[mul]") {
+    TransformTableCache<int> cache;
+    int built = 0;
+    auto make = [&](int n) {
+        ++built;
+        return vector<int>(n, n);
+    };
+    auto small = cache.get(4, make);
+    REQUIRE(cache.get(4, make) == small);
+    REQUIRE(built == 1);
+    REQUIRE((*small)[0] == 16);
+
+    // Каждая следующая таблица вытесняет самые давние, что не влезают.
+    TransformTableBudget &budget = TransformTableBudget::instance();
+    const size_t max_bytes = TransformTableBudget::MAX_BYTES;
+    for (int log = 10; log <= 23; ++log) cache.get(log, make);
+    REQUIRE(budget.bytes() <= max_bytes);
+    REQUIRE((*small)[15] == 16);
+    cache.get(4, make);
+    REQUIRE(built == 16);
+
+    // Бюджет общий для всех кэшей: таблица другого типа вытесняет эти.
+    TransformTableCache<double> other;
+    other.get(21, [](int n) { return vector<double>(n); });
+    REQUIRE(other.bytes() == (size_t) 8 << 21);
+    REQUIRE(cache.bytes() + other.bytes() <= max_bytes);
+    REQUIRE(budget.bytes() <= max_bytes);
+
+    // Таблица больше всего бюджета строится, но не хранится.
+    size_t before = budget.bytes();
+    auto huge = cache.get(24, make);
+    REQUIRE(huge->size() == (size_t) 1 << 24);
+    REQUIRE(budget.bytes() == before);
+    cache.get(24, make);
+    REQUIRE(built == 18);
+    REQUIRE(other.bytes() == (size_t) 8 << 21);
+}
+
+TEST_CASE("Большие произведения точны", "[mul]") {
+    // (10^k - 1)^2 = 10^2k - 2 * 10^k + 1, все лимбы максимальные.
+    const int k = 9 * 5000;
+    BigInt nines(string(k, '9'));
+    string expected = string(k - 1, '9') + "8" + string(k - 1, '0') + "1";
+    REQUIRE(to_string(nines * nines) == expected);
+    REQUIRE(to_string(nines * -nines) == "-" + expected);
+}
+
+TEST_CASE("Algorithm D совпадает со школьным делением", "[div]") {
+    mt19937 gen(2021);
+    for (int m : {1, 2, 3, 10, 77}) {
+        for (int n : {m - 1, m, m + 1, 3 * m + 5}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            auto fast = BigInt::divmod_knuth(x, y);
+            auto slow = BigInt::divmod_simple(x, y);
+            REQUIRE(fast.first == slow.first);
+            REQUIRE(fast.second == slow.second);
+        }
+    }
+    SECTION("оценка цифры частного с возвратом делителя") {
+        auto res = BigInt::divmod_knuth(
+            BigInt("499999999000000000999999999499999999333333333"),
+            BigInt("500000000000000001999999998"));
+        REQUIRE(to_string(res.first) == "999999997999999998");
+        REQUIRE(to_string(res.second) == "5499999999333333329");
+        res = BigInt::divmod_knuth(BigInt("333333333500000001333333333000000001"),
+                                   BigInt("333333333500000001499999999"));
+        REQUIRE(to_string(res.first) == "999999999");
+        REQUIRE(to_string(res.second) == "333333333333333335500000000");
+    }
+}
+
+TEST_CASE("Деление через ньютоновский обратный", "[div]") {
+    mt19937 gen(2020);
+    for (int m : {50, 333, BigInt::NEWTON_THRESHOLD + 100}) {
+        for (int n : {m, m + 3, m + 200, 2 * m, 5 * m + 1}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            auto fast = BigInt::divmod_newton(x, y);
+            auto slow = BigInt::divmod_knuth(x, y);
+            REQUIRE(fast.first == slow.first);
+            REQUIRE(fast.second == slow.second);
+            REQUIRE(fast.first * y + fast.second == x);
+        }
+    }
+    SECTION("знаки как у divmod") {
+        BigInt x = random_bigint(700, gen), y = random_bigint(300, gen);
+        auto q = x / y;
+        REQUIRE(-x / y == -q);
+        REQUIRE(x / -y == -q);
+        REQUIRE(-x / -y == q);
+        REQUIRE(x % y == x - q * y);
+    }
+}
+
+TEST_CASE("BigIntDivisor делит так же, как divmod", "[div]") {
+    mt19937 gen(2031);
+    for (int m : {1, 2, 30, BigInt::NEWTON_THRESHOLD + 20}) {
+        BigInt b = random_bigint(m, gen);
+        for (BigInt d : {b, -b}) {
+            BigIntDivisor divisor(d);
+            REQUIRE(divisor.divisor() == d);
+            for (int n : {0, 1, m, m + 1, 2 * m + 5, m + BigInt::NEWTON_THRESHOLD + 7}) {
+                BigInt a = random_bigint(n, gen);
+                for (BigInt x : {a, -a}) {
+                    auto res = divisor.divmod(x);
+                    auto expected = divmod(x, d);
+                    REQUIRE(res.first == expected.first);
+                    REQUIRE(res.second == expected.second);
+                    REQUIRE(divisor.div(x) == x / d);
+                    REQUIRE(divisor.mod(x) == x % d);
+                }
+            }
+        }
+    }
+    SECTION("обратный к лимбу") {
+        for (long long d : {1LL, 2LL, 3LL, 999999999LL, 500000000LL, 123457LL}) {
+            LimbDivisor limb(d);
+            for (unsigned long long num : {0ULL, (unsigned long long) d - 1, 999999999999999999ULL % (d * BASE),
+                                           (unsigned long long) d * BASE - 1}) {
+                long long q, r;
+                limb.divide(num, q, r);
+                REQUIRE(q == (long long) (num / d));
+                REQUIRE(r == (long long) (num % d));
+            }
+        }
+    }
+}
+
+TEST_CASE("НОД Лемера и half-GCD совпадает с алгоритмом Евклида", "[gcd]") {
+    mt19937 gen(2032);
+    for (int n : {1, 2, 3, 10, 60, 300}) {
+        for (int m : {1, n / 2 + 1, n - 1, n}) {
+            if (m < 1) continue;
+            BigInt z = random_bigint(1 + gen() % 5, gen);
+            BigInt x = random_bigint(n, gen) * z, y = random_bigint(m, gen) * z;
+            BigInt g = gcd(x, y);
+            REQUIRE(g == BigInt::gcd_euclid(x, y));
+            REQUIRE(gcd(-x, y) == g);
+            REQUIRE(gcd(y, -x) == g);
+        }
+    }
+    SECTION("крайние случаи") {
+        REQUIRE(gcd(BigInt(0), BigInt(0)) == 0);
+        REQUIRE(gcd(BigInt(0), BigInt(-7)) == 7);
+        REQUIRE(gcd(BigInt("1000000000000000000000000"), BigInt(0)) == BigInt("1000000000000000000000000"));
+        REQUIRE(BigInt::gcd_binary(48, 180) == 12);
+        REQUIRE(BigInt::gcd_binary(0, 5) == 5);
+        REQUIRE(lcm(BigInt(4), BigInt(6)) == 12);
+        // Соседние числа Фибоначчи — самый длинный ряд частных, все равны 1.
+        BigInt f0 = 1, f1 = 1;
+        for (int i = 0; i < 3000; ++i) {
+            BigInt t = f0 + f1;
+            f0 = std::move(f1);
+            f1 = std::move(t);
+        }
+        REQUIRE(gcd(f1, f0) == 1);
+        REQUIRE(gcd(f1 * 6, f0 * 4) == 2);
+    }
+    SECTION("half-GCD") {
+        int n = BigInt::HGCD_THRESHOLD + 200;
+        BigInt z = random_bigint(300, gen);
+        BigInt x = random_bigint(n, gen) * z, y = random_bigint(n - 7, gen) * z;
+        BigInt g = gcd(x, y);
+        REQUIRE((x % g).isZero());
+        REQUIRE((y % g).isZero());
+        REQUIRE(gcd(x / g, y / g) == 1);
+        REQUIRE((g % z).isZero());
+
+        BigInt a = x, b = y, m[4];
+        int det;
+        BigInt::hgcd(a, b, m, det);
+        REQUIRE(a > b);
+        REQUIRE((int) b.a.size() <= (int) x.a.size() / 2 + 1);
+        REQUIRE(m[0] * m[3] - m[1] * m[2] == det);
+        REQUIRE(m[0] * a + m[1] * b == x);
+        REQUIRE(m[2] * a + m[3] * b == y);
+    }
+}
+
+TEST_CASE("Корни Ньютоном с остатком", "[roots]") {
+    mt19937 gen(2033);
+    for (int n : {1, 2, 3, 4, 5, 9, 40, 333}) {
+        BigInt x = random_bigint(n, gen);
+        auto sr = sqrt_rem(x);
+        REQUIRE(sr.first * sr.first + sr.second == x);
+        REQUIRE(sr.second >= 0);
+        REQUIRE(sr.second <= sr.first * 2);
+        if (n <= 40) REQUIRE(sr.first == BigInt::sqrt_simple(x));
+        REQUIRE(sqrt(sr.first * sr.first) == sr.first);
+        REQUIRE(sqrt(sr.first * sr.first - 1) == sr.first - 1);
+
+        for (int k : {3, 5, 17}) {
+            auto rr = nth_root_rem(x, k);
+            REQUIRE(pow(rr.first, k) + rr.second == x);
+            REQUIRE(rr.second >= 0);
+            REQUIRE(pow(rr.first + 1, k) > x);
+        }
+    }
+    REQUIRE(sqrt(BigInt(0)) == 0);
+    REQUIRE(nth_root(BigInt(0), 4) == 0);
+    REQUIRE(nth_root(BigInt(7), 1) == 7);
+    REQUIRE(nth_root(pow(BigInt(10), 90), 9) == BigInt("10000000000"));
+    REQUIRE(nth_root(pow(BigInt(10), 90) - 1, 9) == BigInt("9999999999"));
+
+    // Старший лимб из одной-двух цифр: корень почти в BASE^2, а в двух
+    // старших лимбах лишь девять его верных цифр.
+    BigInt big = pow(BigInt(10), 531) + BigInt(987654321) * pow(BigInt(10), 520);
+    for (int k : {10, 13, 30, 59}) {
+        auto rr = nth_root_rem(big, k);
+        REQUIRE(pow(rr.first, k) + rr.second == big);
+        REQUIRE(rr.second >= 0);
+        REQUIRE(pow(rr.first + 1, k) > big);
+    }
+    for (int k : {10, 17}) {
+        BigInt x = pow(BigInt(123456789), k) * 7 + 1;
+        auto rr = nth_root_rem(x, k);
+        REQUIRE(pow(rr.first, k) + rr.second == x);
+        REQUIRE(pow(rr.first + 1, k) > x);
+    }
+}
+
+TEST_CASE("Произведения и суммы деревом", "[tree]") {
+    mt19937 gen(2034);
+    vector<BigInt> xs;
+    BigInt left_product = 1, left_sum = 0;
+    for (int i = 0; i < 300; ++i) {
+        xs.push_back(random_bigint(1 + gen() % 4, gen));
+        if (gen() % 3 == 0) xs.back() = -xs.back();
+        left_product *= xs.back();
+        left_sum += xs.back();
+    }
+    REQUIRE(product(xs.begin(), xs.end()) == left_product);
+    REQUIRE(sum(xs.begin(), xs.end()) == left_sum);
+    REQUIRE(product(xs.begin(), xs.begin()) == 1);
+    REQUIRE(sum(xs.begin(), xs.begin()) == 0);
+    REQUIRE(product(xs.begin(), xs.begin() + 1) == xs[0]);
+
+    REQUIRE(factorial(0) == 1);
+    REQUIRE(factorial(1) == 1);
+    REQUIRE(to_string(factorial(20)) == "2432902008176640000");
+    REQUIRE(to_string(factorial(30)) == "265252859812191058636308480000000");
+    BigInt f = 1;
+    for (int i = 2; i <= 1000; ++i) f *= i;
+    REQUIRE(factorial(1000) == f);
+    REQUIRE(to_string(factorial<BinaryBigInt>(1000)) == to_string(f));
+    REQUIRE(range_product(5, 4) == 1);
+
+    REQUIRE(binomial(10, 11) == 0);
+    REQUIRE(binomial(10, 0) == 1);
+    REQUIRE(binomial(10, 3) == 120);
+    REQUIRE(to_string(binomial(100, 50)) == "100891344545564193334812497256");
+    REQUIRE(binomial(1000, 400) == factorial(1000) / factorial(400) / factorial(600));
+
+    SECTION("цепочки умножений в калькуляторе") {
+        string expression;
+        BigInt expected;
+        for (int i = 0; i < 60; ++i) {
+            BigInt x = random_bigint(1 + gen() % 3, gen);
+            if (!i) {
+                expected = x;
+                expression = to_string(x);
+            } else if (i % 17 == 0) {
+                expected /= x;
+                expression += " / " + to_string(x);
+            } else {
+                expected *= x;
+                expression += " * " + to_string(x);
+            }
+        }
+        CCalculator calc;
+        REQUIRE(calc.process(expression.c_str()) == expected);
+        REQUIRE(calc.process((expression + " - 1 * 2 * 3").c_str()) == expected - 6);
+        REQUIRE(calc.process("-2 * 3 * -4 / 5 * 7") == 28);
+        REQUIRE_THROWS_AS(calc.process("2 * 3 * 4 / 0 * 5"), CDivisionByZero);
+        REQUIRE(calc.process("2 * 3") == 6);
+    }
+}
+
+TEST_CASE("Модульная арифметика Барретта совпадает с делением", "[mod]") {
+    mt19937 gen(2030);
+    for (int k : {1, 2, 7, 40, 150}) {
+        BigInt m = random_bigint(k, gen);
+        BigIntModulus mod(m);
+        for (int n : {1, k, 2 * k, 5 * k + 3}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(k, gen) % m;
+            REQUIRE(mod.residue(x) == x % m);
+            REQUIRE(mod.residue(-x) == -x % m);
+            BigInt r = x % m;
+            REQUIRE(mod.mulmod(r, y) == r * y % m);
+            REQUIRE(mod.mulmod(r, r) == r * r % m);
+        }
+        BigInt x = random_bigint(k, gen), e = random_bigint(3, gen), expected = 1;
+        for (BigInt b = x % m, t = e; !t.isZero(); t /= 2, b = b * b % m) {
+            if (t % 2) expected = expected * b % m;
+        }
+        REQUIRE(mod.powmod(x, e) == expected);
+        REQUIRE(mod.powmod(x, 0) == BigInt(1) % m);
+        REQUIRE(mod.powmod(x, 1000003) == mod.powmod(x, BigInt(1000003)));
+
+        BigInt inv = mod.invmod(x);
+        if (gcd(x, m) == 1) {
+            REQUIRE(inv * x % m == BigInt(1) % m);
+        } else {
+            REQUIRE(inv == 0);
+        }
+    }
+    SECTION("малые модули") {
+        BigIntModulus one(1), even(1000000000);
+        REQUIRE(one.powmod(5, 10) == 0);
+        REQUIRE(one.invmod(5) == 0);
+        REQUIRE(even.invmod(2) == 0);
+        REQUIRE(even.invmod(7) * 7 % BigInt(1000000000) == 1);
+        REQUIRE(BigIntModulus(97).invmod(-5) == 58);
+        REQUIRE(to_string(BigIntModulus(BigInt("1000000000000000000000007"))
+                              .powmod(2, BigInt("1000000000000000000000006"))) == "1");
+    }
+}
+
+TEST_CASE("Векторные ядра сложения и умножения на int совпадают со скалярными", "[kernels]") {
+    mt19937 gen(2028);
+    // Без AVX2 векторные ядра упали бы на недопустимой инструкции.
+    if (!BigInt::cpu_has_avx2()) {
+        WARN("процессор без AVX2, векторные ядра не проверяются");
+        return;
+    }
+    BigInt::LimbKernels simd = BigInt::simd_kernels(true);
+    BigInt::LimbKernels scalar = BigInt::simd_kernels(false);
+    // Случайные лимбы, а также длинные цепочки переносов: 0 и BASE - 1.
+    auto limbs = [&](int n, int kind) {
+        vector<int> x(n);
+        for (int &d : x)
+            d = kind == 0 ? gen() % BASE : kind == 1 ? BASE - 1 - gen() % 2 : gen() % 2;
+        return x;
+    };
+    for (int n : {0, 1, 7, 8, 9, 16, 63, 1000}) {
+        for (int kind = 0; kind < 3; ++kind) {
+            for (int carry : {0, 1}) {
+                vector<int> a = limbs(n, kind), b = limbs(n, (kind + 1) % 3);
+                vector<int> x = a, y = a;
+                REQUIRE(simd.add(x.data(), b.data(), n, carry) ==
+                        scalar.add(y.data(), b.data(), n, carry));
+                REQUIRE(x == y);
+                x = y = a;
+                REQUIRE(simd.sub(x.data(), b.data(), n, carry) ==
+                        scalar.sub(y.data(), b.data(), n, carry));
+                REQUIRE(x == y);
+                for (int v : {0, 1, 2, 10, 999999999, int(gen() % BASE)}) {
+                    x = y = a;
+                    int c = carry ? BASE - 1 : 0;
+                    REQUIRE(simd.mul_small(x.data(), n, v, c) ==
+                            scalar.mul_small(y.data(), n, v, c));
+                    REQUIRE(x == y);
+                }
+            }
+        }
+    }
+}
+
+// Счетчик обращений к куче: глобальный operator new перекрыт целиком.
+static atomic<size_t> g_allocations(0);
+void *operator new(size_t size) {
+    ++g_allocations;
+    if (void *p = malloc(size)) return p;
+    throw bad_alloc();
+}
+void operator delete(void *p) noexcept {
+    free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+// Считает блоки лимбов, взятые из кучи.
+class CountingLimbResource : public LimbResource {
+  public:
+    int allocations = 0;
+    void *allocate(size_t bytes) override {
+        ++allocations;
+        return ::operator new(bytes);
+    }
+    void deallocate(void *p, size_t) override {
+        ::operator delete(p);
+    }
+};
+
+TEST_CASE("Операторы над временными дают то же, что над копиями", "[ops]") {
+    mt19937 gen(2029);
+    for (int n : {1, 3, 20}) {
+        for (int m : {1, 2, 20}) {
+            BigInt x = random_bigint(n, gen), y = random_bigint(m, gen);
+            if (gen() & 1) x = -x;
+            if (gen() & 1) y = -y;
+            const BigInt cx = x, cy = y;
+            BigInt sum = cx + cy, diff = cx - cy, prod = cx * cy;
+            BigInt quot = cx / cy, rem = cx % cy;
+            REQUIRE(BigInt(x) - y == diff);
+            REQUIRE(x - BigInt(y) == diff);
+            REQUIRE(BigInt(x) - BigInt(y) == diff);
+            REQUIRE(x - BigInt(x) == 0);
+            REQUIRE(BigInt(x) + BigInt(y) == sum);
+            REQUIRE(BigInt(x) * y == prod);
+            REQUIRE(x * BigInt(y) == prod);
+            REQUIRE(BigInt(x) * BigInt(y) == prod);
+            REQUIRE(BigInt(x) / y == quot);
+            REQUIRE(BigInt(x) % y == rem);
+            REQUIRE(BigInt(prod) / y == x);
+            REQUIRE(BigInt(prod) % y == 0);
+            REQUIRE(BigInt(x) * 7 == cx * 7);
+            REQUIRE(BigInt(x) / 7 == cx / 7);
+            REQUIRE(-BigInt(x) == -cx);
+            REQUIRE(BigInt(x).abs() == cx.abs());
+            REQUIRE(divmod(cx, cy).first == quot);
+            REQUIRE(divmod(cx, cy).second == rem);
+            BigInt z = x;
+            z *= y;
+            REQUIRE(z == prod);
+            z /= y;
+            REQUIRE(z == divmod(prod, cy).first);
+            z = y;
+            z += x;
+            REQUIRE(z == sum);
+            z = y;
+            z -= x;
+            REQUIRE(z == -diff);
+        }
+    }
+    REQUIRE(to_string(-(BigInt(5) - BigInt(5))) == "0");
+    REQUIRE(to_string(BigInt(-3) * BigInt(0)) == "0");
+
+    SECTION("произведение двух временных масштабирует длинное на месте") {
+        CountingLimbResource counting;
+        LimbResourceScope scope(&counting);
+        BigInt x = random_bigint(20, gen);
+        BigInt expected = x * 3;
+        for (bool long_first : {true, false}) {
+            // Своя копия лимбов, с местом под перенос.
+            BigInt big = x, small = 3;
+            big.a.reserve(big.a.size() + 1);
+            int before = counting.allocations;
+            BigInt p = long_first ? std::move(big) * std::move(small)
+                                  : std::move(small) * std::move(big);
+            REQUIRE(counting.allocations == before);
+            REQUIRE(p == expected);
+        }
+    }
+    SECTION("деление временного идет в его же лимбах") {
+        CountingLimbResource counting;
+        LimbResourceScope scope(&counting);
+        BigInt x = random_bigint(20, gen), y = -random_bigint(3, gen);
+        BigInt quot = divmod(x, y).first, rem = divmod(x, y).second;
+        for (bool remainder : {false, true}) {
+            BigInt t = x;
+            t.a.reserve(t.a.size() + 1);
+            int before = counting.allocations;
+            BigInt res = remainder ? std::move(t) % y : std::move(t) / y;
+            REQUIRE(counting.allocations == before);
+            REQUIRE(res == (remainder ? rem : quot));
+        }
+    }
+}
+
+TEST_CASE("LimbVector держит короткие числа внутри и растет в кучу", "[limbs]") {
+    LimbVector v;
+    for (int i = 0; i < 3 * LimbVector::INLINE_LIMBS; ++i) {
+        v.push_back(i);
+        REQUIRE(v.size() == i + 1);
+        REQUIRE(v.back() == i);
+    }
+    LimbVector copy = v;
+    LimbVector moved = std::move(v);
+    REQUIRE(v.empty());
+    REQUIRE(copy.size() == moved.size());
+    for (size_t i = 0; i < copy.size(); ++i) REQUIRE(copy[i] == moved[i]);
+
+    SECTION("перемещение коротких копирует лимбы") {
+        LimbVector small;
+        small.resize(2, 7);
+        moved = std::move(small);
+        REQUIRE(moved.size() == 2);
+        REQUIRE(moved[0] == 7);
+        REQUIRE(moved[1] == 7);
+    }
+    SECTION("BigInt переживает переход через границу") {
+        BigInt x(999999999);
+        BigInt y = 1;
+        for (int i = 0; i < 4 * LimbVector::INLINE_LIMBS; ++i) y *= x;
+        for (int i = 0; i < 4 * LimbVector::INLINE_LIMBS; ++i) y /= x;
+        REQUIRE(y == 1);
+    }
+}
+
+// Без BIGINT_SHARED_LIMBS копии и так независимы, тогда проверяется только
+// это; с ним — еще и то, что копия не трогает кучу, пока ее не меняют.
+TEST_CASE("Копии независимы, общие лимбы отделяются при записи", "[limbs]") {
+    mt19937 gen(2038);
+    BigInt x = random_bigint(100, gen);
+    const string digits = to_string(x);
+
+    BigInt y = x;
+#ifdef BIGINT_SHARED_LIMBS
+    const BigInt &cx = x, &cy = y;
+    REQUIRE(cy.a.data() == cx.a.data());
+    BigInt z = -x, w = y.abs();
+    REQUIRE(static_cast<const BigInt &>(z).a.data() == cx.a.data());
+    REQUIRE(static_cast<const BigInt &>(w).a.data() == cx.a.data());
+#endif
+    y += 1;
+    REQUIRE(y == x + 1);
+    REQUIRE(to_string(x) == digits);
+
+    BigInt v = x;
+    v.a[0] = 0;
+    REQUIRE(to_string(x) == digits);
+    v = x;
+    v.a.push_back(1);
+    v.a.pop_back();
+    v.a.resize(50);
+    REQUIRE(to_string(x) == digits);
+    v = x;
+    x.a.assign(3, 7);
+    REQUIRE(to_string(v) == digits);
+    REQUIRE(to_string(x) == "7000000007000000007");
+
+    SECTION("копия из арены уходит в кучу") {
+        BigInt result;
+        {
+            BigIntArena arena(1 << 16);
+            BigInt value;
+            {
+                LimbResourceScope scope(arena.resource());
+                value = v * v;
+                BigInt inside = value;
+                inside -= 1;
+                REQUIRE(inside + 1 == value);
+            }
+            result = value;
+            REQUIRE(static_cast<const BigInt &>(result).a.data() !=
+                    static_cast<const BigInt &>(value).a.data());
+        }
+        REQUIRE(result == v * v);
+    }
+    SECTION("общие лимбы в разных потоках") {
+        vector<BigInt> copies(4, v);
+        vector<thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&copies, t] {
+                for (int i = 0; i < 100; ++i) {
+                    BigInt local = copies[t];
+                    local *= t + 2;
+                    copies[t] = local / (t + 2);
+                }
+            });
+        }
+        for (thread &t : threads) t.join();
+        for (const BigInt &c : copies) REQUIRE(to_string(c) == digits);
+    }
+}
+
+TEST_CASE("Лимбы из арены LinearAllocator", "[arena]") {
+    mt19937 gen(2022);
+    BigInt x = random_bigint(100, gen), y = random_bigint(70, gen);
+    BigInt expected = x * y - x / y;
+
+    for (size_t size : {0, 64, 1 << 16}) {
+        BigIntArena arena(size);
+        BigInt result;
+        {
+            LimbResourceScope scope(arena.resource());
+            BigInt value = x * y - x / y;
+            REQUIRE(value == expected);
+            result = std::move(value);
+        }
+        BigInt copy = result;
+        result = BigInt();
+        arena.reset();
+        REQUIRE(copy == expected);
+    }
+
+    SECTION("калькулятор сбрасывает арену между выражениями") {
+        string big = to_string(random_bigint(40, gen));
+        string expression = big + " * " + big + " - " + big + " / 7";
+        BigInt value = BigInt(big) * BigInt(big) - BigInt(big) / 7;
+        for (size_t size : {0, 256, 1 << 20}) {
+            CCalculator calc(size);
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(calc.process(expression.c_str()) == value);
+                REQUIRE_THROWS_AS(calc.process((expression + "+").c_str()),
+                                  CSyntaxError);
+            }
+        }
+    }
+}
+
+// Все промежуточное — в арене, в кучу идет разве что копия длинного
+// результата, а здесь результаты короткие.
+TEST_CASE("Калькулятор не ходит в кучу на типичных выражениях", "[arena]") {
+    mt19937 gen(2040);
+    string big = to_string(random_bigint(12, gen));
+    string expressions[] = {
+        "7+6+7+8-5",
+        "1695934565+ 1110774670- -603242537+-1630721439",
+        big + " + " + big + " - " + big + " - " + big + " + 5",
+        "2 + 3 * 4 - -2",
+        "-724+     627/      -66-609*   -466+  953* -     591*   696",
+        big + " * 3 * 5 / " + big + " - 10",
+    };
+    BigInt values[] = {23, BigInt("1779230333"), 5, 16, BigInt("-391720147"), 5};
+    for (int i = 0; i < 6; ++i) {
+        CCalculator calc;
+        size_t before = g_allocations;
+        BigInt value = calc.process(expressions[i].c_str());
+        size_t allocations = g_allocations - before;
+        INFO(expressions[i]);
+        REQUIRE(allocations == 0);
+        REQUIRE(value == values[i]);
+    }
+}
+
+// Десятичная строка из n случайных цифр, иногда со знаком минус.
+static string random_decimal(int n, mt19937 &gen) {
+    string s = (gen() & 1) ? "-" : "";
+    s += char('1' + gen() % 9);
+    for (int i = 1; i < n; ++i) s += char('0' + gen() % 10);
+    return s;
+}
+
+TEST_CASE("BinaryBigInt считает так же, как BigInt", "[binary]") {
+    mt19937 gen(2027);
+    for (int n : {1, 18, 19, 20, 39, 300, 700, 2000}) {
+        for (int m : {1, 19, 25, 300, 1500}) {
+            string xs = random_decimal(n, gen), ys = random_decimal(m, gen);
+            BigInt x(xs), y(ys);
+            BinaryBigInt bx(xs), by(ys);
+            REQUIRE(to_string(bx) == xs);
+            REQUIRE(to_string(bx + by) == to_string(x + y));
+            REQUIRE(to_string(bx - by) == to_string(x - y));
+            REQUIRE(to_string(bx * by) == to_string(x * y));
+            REQUIRE(to_string(bx / by) == to_string(x / y));
+            REQUIRE(to_string(bx % by) == to_string(x % y));
+            REQUIRE(to_string(bx * -7) == to_string(x * -7));
+            REQUIRE(to_string(bx / 7) == to_string(x / 7));
+            REQUIRE(bx % 999999937 == x % 999999937);
+            REQUIRE((bx < by) == (x < y));
+        }
+    }
+    SECTION("сдвиги") {
+        BinaryBigInt x(random_decimal(500, gen));
+        for (int bits : {0, 1, 63, 64, 65, 200}) {
+            BinaryBigInt p = 1;
+            for (int i = 0; i < bits; ++i) p *= 2;
+            REQUIRE((x << bits) == x * p);
+            REQUIRE((x << bits >> bits) == x);
+            REQUIRE((x >> bits) == x / p);
+        }
+    }
+    SECTION("деление с возвратом делителя") {
+        BinaryBigInt u("11579208923731619542357098500868790785292970229871962557600"
+                       "3432772518216204287"),
+            v("510423550381407695222732027258216644609");
+        REQUIRE(to_string(u / v) == "226854911280625642296618575572039106559");
+        REQUIRE(to_string(u % v) == "283568639100782052935336823723032313856");
+    }
+    SECTION("длинные числа переводятся туда и обратно") {
+        string s = random_decimal(100000, gen);
+        string nines(30000, '9');
+        REQUIRE(to_string(BinaryBigInt(s)) == s);
+        REQUIRE(to_string(BinaryBigInt(nines)) == nines);
+        REQUIRE(to_string(BinaryBigInt("1" + string(19 * 64, '0'))) ==
+                "1" + string(19 * 64, '0'));
+        REQUIRE(to_string(BinaryBigInt("-0")) == "0");
+    }
+    SECTION("длинные произведения через NTT") {
+        // Больше NTT_THRESHOLD лимбов в каждом множителе, длины разные.
+        string xs = random_decimal(19 * 9000, gen), ys = random_decimal(19 * 12000, gen);
+        BigInt x(xs), y(ys);
+        BinaryBigInt bx(xs), by(ys);
+        REQUIRE(to_string(bx * by) == to_string(x * y));
+        REQUIRE(to_string(bx * bx) == to_string(x * x));
+        string ns(19 * 9000, '9');
+        BinaryBigInt nines(ns);
+        REQUIRE(to_string(nines * nines) == to_string(pow(BigInt(ns), 2)));
+    }
+    SECTION("умножение на INT_MIN") {
+        BinaryBigInt x(random_decimal(60, gen));
+        REQUIRE((x * (-2147483647 - 1)) == x * BinaryBigInt(-2147483648LL));
+    }
+    SECTION("калькулятор на двоичных лимбах") {
+        CBasicCalculator<BinaryBigInt> binary;
+        CCalculator decimal;
+        for (const char *expression :
+             {"2 + 3 * 4 - -2", "-515/219*  140",
+              "1695934565+ 1110774670- -603242537* -561540301+-1630721439",
+              "99999999999999999999 * 99999999999999999999 / 7 - 1"}) {
+            REQUIRE(to_string(binary.process(expression)) ==
+                    to_string(decimal.process(expression)));
+        }
+        REQUIRE_THROWS_AS(binary.process("1 / 0"), CDivisionByZero);
+    }
+}
+
+// Все выражения ниже считаются при компиляции.
+static_assert(FixedBigInt<128>(-7) / 2 == -3, "");
+static_assert(FixedBigInt<128>(-7) % 2 == 1, "");
+static_assert((FixedBigInt<128>(1) * (1LL << 62) * (1LL << 62)).a[1] == 1ULL << 60, "");
+static_assert(FixedBigInt<128>::max() + FixedBigInt<128>::min() == -1, "");
+static_assert(FixedBigInt<192>(123456789) * 987654321 / 987654321 == 123456789, "");
+
+TEST_CASE("FixedBigInt считает так же, как BigInt, и ловит переполнение", "[fixed]") {
+    typedef FixedBigInt<256> Fixed;
+    const BigInt max = pow(BigInt(2), 255) - 1, min = -pow(BigInt(2), 255);
+    REQUIRE(to_string(max) == to_string(Fixed::max()));
+    REQUIRE(to_string(min) == to_string(Fixed::min()));
+    REQUIRE(Fixed(to_string(min)) == Fixed::min());
+
+    mt19937 gen(2036);
+    for (int n : {1, 9, 19, 20, 38, 40, 57, 76}) {
+        for (int m : {1, 5, 19, 20, 38, 60, 76}) {
+            string xs = random_decimal(n, gen), ys = random_decimal(m, gen);
+            BigInt x(xs), y(ys);
+            Fixed fx(xs), fy(ys);
+            REQUIRE(to_string(fx) == xs);
+            REQUIRE(to_string(fx + fy) == to_string(x + y));
+            REQUIRE(to_string(fx - fy) == to_string(x - y));
+            if (x * y <= max && x * y >= min) {
+                REQUIRE(to_string(fx * fy) == to_string(x * y));
+            } else {
+                REQUIRE_THROWS_AS(fx * fy, FixedBigIntOverflow);
+            }
+            REQUIRE(to_string(fx / fy) == to_string(x / y));
+            REQUIRE(to_string(fx % fy) == to_string(x % y));
+            if (n < 76) REQUIRE(to_string(fx * -7 / -7) == xs);
+            REQUIRE((fx < fy) == (x < y));
+            REQUIRE((fx == fy) == (x == y));
+        }
+    }
+    SECTION("переполнение") {
+        REQUIRE_THROWS_AS(Fixed::max() + 1, FixedBigIntOverflow);
+        REQUIRE_THROWS_AS(Fixed::min() - 1, FixedBigIntOverflow);
+        REQUIRE_THROWS_AS(-Fixed::min(), FixedBigIntOverflow);
+        REQUIRE_THROWS_AS(Fixed::min() / -1, FixedBigIntOverflow);
+        REQUIRE_THROWS_AS(Fixed::min() * -1, FixedBigIntOverflow);
+        REQUIRE_THROWS_AS(Fixed(to_string(max + 1)), FixedBigIntOverflow);
+        REQUIRE(Fixed::min() * 1 == Fixed::min());
+        REQUIRE(Fixed::min() / 2 * 2 == Fixed::min());
+        REQUIRE(to_string(Fixed::min() % -1) == "0");
+        REQUIRE(to_string(Fixed::max() - Fixed::max()) == "0");
+    }
+    SECTION("калькулятор на FixedBigInt") {
+        CBasicCalculator<Fixed> fixed;
+        CCalculator decimal;
+        for (const char *expression :
+             {"2 + 3 * 4 - -2", "-515/219*  140",
+              "1695934565+ 1110774670- -603242537* -561540301+-1630721439",
+              "99999999999999999999 * 99999999999999999999 / 7 - 1"}) {
+            REQUIRE(to_string(fixed.process(expression)) ==
+                    to_string(decimal.process(expression)));
+        }
+        REQUIRE_THROWS_AS(fixed.process("1 / 0"), CDivisionByZero);
+        REQUIRE_THROWS_AS(fixed.process("340282366920938463463374607431768211456 * "
+                                        "340282366920938463463374607431768211456"),
+                          FixedBigIntOverflow);
+    }
+}
+
+TEST_CASE("BigIntAccumulator суммирует так же, как +=", "[acc]") {
+    mt19937 gen(2037);
+    for (int n : {1, 3, 40, 300}) {
+        BigIntAccumulator acc;
+        BigInt expected;
+        for (int i = 0; i < 2000; ++i) {
+            BigInt x = random_bigint(1 + gen() % n, gen);
+            if (gen() % 3 == 0) x = -x;
+            if (gen() % 2) {
+                acc += x;
+                expected += x;
+            } else {
+                acc -= x;
+                expected -= x;
+            }
+            // Чтение посередине нормализует, дальше копим как ни в чем не бывало.
+            if (i % 500 == 0) REQUIRE(acc.value() == expected);
+        }
+        REQUIRE(acc.value() == expected);
+        acc -= expected;
+        REQUIRE(to_string(acc.value()) == "0");
+        acc -= expected;
+        REQUIRE(acc.value() == -expected);
+        acc = BigInt(5);
+        REQUIRE(acc.value() == 5);
+    }
+    SECTION("переносы через много лимбов") {
+        BigInt big = BigInt(1).shift_limbs(10);
+        BigIntAccumulator acc(big);
+        acc -= 1;
+        REQUIRE(acc.value() == big - 1);
+        acc -= big;
+        REQUIRE(acc.value() == -1);
+        acc += BigInt(BASE - 1).shift_limbs(3) * 3;
+        REQUIRE(acc.value() == BigInt(BASE - 1).shift_limbs(3) * 3 - 1);
+        REQUIRE(to_string(BigIntAccumulator().value()) == "0");
+    }
+    SECTION("калькулятор с длинной цепочкой слагаемых") {
+        string expression = "0";
+        BigInt expected;
+        for (int i = 0; i < 500; ++i) {
+            BigInt x = random_bigint(1 + gen() % 5, gen);
+            if (i % 2) {
+                expected += x;
+                expression += " + " + to_string(x);
+            } else {
+                expected -= x * 3;
+                expression += " - " + to_string(x) + " * 3";
+            }
+        }
+        CCalculator calc;
+        REQUIRE(calc.process(expression.c_str()) == expected);
+        REQUIRE(calc.process("1 - 2 - 3") == -4);
+        REQUIRE(calc.process("5 - 5") == 0);
+    }
+}
+
+TEST_CASE("Двоичный формат и отображенные в память файлы", "[serialize]") {
+    mt19937 gen(2039);
+    vector<BigInt> xs = {BigInt(0), BigInt(-1), BigInt(BASE - 1), BigInt(BASE)};
+    for (int n : {1, 7, 8, 9, 100, 3000}) {
+        xs.push_back(random_bigint(n, gen));
+        xs.push_back(-random_bigint(n, gen));
+    }
+
+    stringstream stream;
+    write_binary_header(stream);
+    for (const BigInt &x : xs) write_binary(stream, x);
+    REQUIRE(read_binary_header(stream));
+    BigInt x;
+    for (const BigInt &expected : xs) {
+        REQUIRE(read_binary(stream, x));
+        REQUIRE(x == expected);
+    }
+    REQUIRE_FALSE(read_binary(stream, x));
+
+    const char *path = "test_bigint.bin";
+    {
+        ofstream out(path, ios::binary);
+        write_binary_header(out);
+        for (const BigInt &x : xs) write_binary(out, x);
+    }
+    {
+        BigIntMappedFile file(path);
+        REQUIRE(file.is_open());
+        REQUIRE(file.size() == xs.size());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            REQUIRE(file[i].to_bigint() == xs[i]);
+            REQUIRE(to_string(file[i]) == to_string(xs[i]));
+            REQUIRE(file[i] == BigIntView(xs[i]));
+            for (size_t j = 0; j < 6; ++j)
+                REQUIRE((file[i] < file[j]) == (xs[i] < xs[j]));
+        }
+    }
+
+    SECTION("чужие и испорченные данные") {
+        string bytes = stream.str();
+        auto corrupt = [&](size_t offset, char value, size_t length) {
+            string damaged = bytes.substr(0, length);
+            if (offset < damaged.size()) damaged[offset] = value;
+            ofstream(path, ios::binary) << damaged;
+            stringstream in(damaged);
+            auto read_all = [&] {
+                BigInt y;
+                read_binary_header(in);
+                while (read_binary(in, y)) {
+                }
+            };
+            REQUIRE_THROWS_AS(read_all(), BigIntFormatError);
+            REQUIRE_THROWS_AS(BigIntMappedFile(path), BigIntFormatError);
+        };
+        corrupt(0, 'X', bytes.size());              // магия
+        corrupt(8, 2, bytes.size());                // версия
+        corrupt(12, 18, bytes.size());              // BASE_DIGITS
+        corrupt(16, 1, bytes.size());               // порядок байт
+        corrupt(24, 5, bytes.size());               // знак первой записи
+        corrupt(31, 0x7f, bytes.size());            // длина первой записи ~2^31
+        corrupt(bytes.size(), 0, 10);               // обрезанный заголовок
+        corrupt(bytes.size(), 0, bytes.size() - 4); // обрезанная последняя запись
+        REQUIRE_FALSE(BigIntMappedFile("no/such/file.bin").is_open());
+        stringstream empty;
+        REQUIRE_FALSE(read_binary_header(empty));
+    }
+    remove(path);
+}
+
+TEST_CASE("Потоковый десятичный ввод и вывод", "[stream]") {
+    mt19937 gen(2040);
+    vector<string> numbers = {"0", "-0", "7", "-1000000000", "999999999", "+12"};
+    for (int n : {8, 9, 10, 17, 18, 19, 1000, 100000}) numbers.push_back(random_decimal(n, gen));
+
+    for (const string &s : numbers) {
+        BigInt expected(s);
+        // Кусками случайной длины, как из сети или файла.
+        BigInt x;
+        BigInt::DecimalReader reader(x);
+        size_t taken = 0;
+        for (size_t pos = 0; pos < s.size();) {
+            size_t len = min(s.size() - pos, (size_t) (1 + gen() % 20));
+            taken += reader.feed(s.data() + pos, len);
+            pos += len;
+        }
+        REQUIRE(taken == s.size());
+        REQUIRE(reader.finish());
+        REQUIRE(x == expected);
+
+        ostringstream old_style;
+        if (expected.sign == -1 && !expected.isZero()) old_style << '-';
+        old_style << (expected.a.empty() ? 0 : expected.a.back());
+        for (int i = (int) expected.a.size() - 2; i >= 0; --i)
+            old_style << setw(BASE_DIGITS) << setfill('0') << expected.a[i];
+        REQUIRE(to_string(expected) == old_style.str());
+    }
+
+    SECTION("operator>> оставляет в потоке то, что после числа") {
+        istringstream in("  -123 +456\n 789abc --5 - x");
+        BigInt x;
+        REQUIRE(in >> x);
+        REQUIRE(x == -123);
+        REQUIRE(in >> x);
+        REQUIRE(x == 456);
+        REQUIRE(in >> x);
+        REQUIRE(x == 789);
+        string rest;
+        in >> rest;
+        REQUIRE(rest == "abc");
+        REQUIRE(in >> x);
+        REQUIRE(x == 5);
+        REQUIRE_FALSE(in >> x);
+
+        istringstream tail("42");
+        REQUIRE(tail >> x);
+        REQUIRE(x == 42);
+        REQUIRE(tail.eof());
+        REQUIRE_FALSE(tail >> x);
+    }
+    SECTION("файловые дескрипторы") {
+        const char *path = "test_bigint.txt";
+        BigInt big(numbers.back());
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        REQUIRE(fd >= 0);
+        REQUIRE(write(fd, "\n\t ", 3) == 3);
+        REQUIRE(write_decimal(fd, big));
+        REQUIRE(write(fd, " 5", 2) == 2);
+        close(fd);
+
+        BigInt x;
+        fd = open(path, O_RDONLY);
+        REQUIRE(read_decimal(fd, x));
+        REQUIRE(x == big);
+        REQUIRE(x.a.capacity() < x.a.size() + x.a.size() / 8 + 16);
+        close(fd);
+        remove(path);
+
+        int pipe_fds[2];
+        REQUIRE(pipe(pipe_fds) == 0);
+        REQUIRE(write_decimal(pipe_fds[1], BigInt("-98765432109876543210")));
+        // Конец канала только для записи: read() возвращает ошибку.
+        REQUIRE_FALSE(read_decimal(pipe_fds[1], x));
+        close(pipe_fds[1]);
+        REQUIRE(read_decimal(pipe_fds[0], x));
+        REQUIRE(to_string(x) == "-98765432109876543210");
+        REQUIRE_FALSE(read_decimal(pipe_fds[0], x));
+        close(pipe_fds[0]);
+    }
+    SECTION("длинные литералы в калькуляторе") {
+        CCalculator calc;
+        string s = random_decimal(20000, gen);
+        if (s[0] == '-') s = s.substr(1);
+        REQUIRE(calc.process(s.c_str()) == BigInt(s));
+        REQUIRE(calc.process(("-" + s + " + 1").c_str()) == BigInt("-" + s) + 1);
+        REQUIRE(calc.process("00000000000000000123") == 123);
+    }
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+#include "bigint.h"
+
+// Подбор порогов между алгоритмами умножения на этой машине.
+// Запуск: ./tune [файл], по умолчанию перезаписывает bigint_tuning.h.
+//
+// Пороги ищутся по очереди снизу вверх: каждый следующий алгоритм сравнивается
+// с тем, что operator* уже умеет с найденными порогами, на сетке размеров.
+
+static const int NEVER = 1 << 30;
+
+static BigInt random_bigint(int n, mt19937 &gen) {
+    BigInt x;
+    x.a.resize(n);
+    for (int i = 0; i < n; ++i) x.a[i] = gen() % BASE;
+    if (n) x.a.back() = 1 + gen() % (BASE - 1);
+    return x;
+}
+
+// Лучшее из трех измерений, каждое не короче 20 мс — шум нам ни к чему.
+static double time_ms(const function<void()> &f) {
+    double best = 1e100;
+    for (int run = 0; run < 3; ++run) {
+        auto start = chrono::steady_clock::now();
+        int iterations = 0;
+        double elapsed;
+        do {
+            f();
+            ++iterations;
+            elapsed =
+                chrono::duration<double>(chrono::steady_clock::now() - start)
+                    .count();
+        } while (elapsed < 0.02);
+        best = min(best, elapsed * 1000 / iterations);
+    }
+    return best;
+}
+
+typedef function<BigInt(const BigInt &, const BigInt &)> Multiply;
+
+static int crossover(const char *name, const Multiply &candidate, int from,
+                     int to) {
+    static const int grid[] = {8,   12,  16,  24,   32,   48,   64,   96,
+                               128, 192, 256, 384,  512,  768,  1024, 1536,
+                               2048, 3072, 4096, 6144, 8192};
+    mt19937 gen(2019);
+    vector<int> sizes;
+    vector<double> gain; // log(current / challenger), > 0 — кандидат быстрее
+    for (int n : grid) {
+        if (n < from || n > to) continue;
+        BigInt x = random_bigint(n, gen), y = random_bigint(n, gen);
+        double current = time_ms([&] { x * y; });
+        double challenger = time_ms([&] { candidate(x, y); });
+        printf("%10s %6d limbs: %10.4f ms vs %10.4f ms\n", name, n, current,
+               challenger);
+        fflush(stdout);
+        sizes.push_back(n);
+        gain.push_back(log(current / challenger));
+    }
+    // Времена скачут (Карацуба, например, добивает длину до степени двойки),
+    // поэтому берем порог, выше которого кандидат выигрывает больше всего
+    // в сумме, а не первую удачную точку.
+    int best = NEVER;
+    double best_gain = 0, suffix = 0;
+    for (int i = (int) sizes.size() - 1; i >= 0; --i) {
+        suffix += gain[i];
+        if (suffix > best_gain) best_gain = suffix, best = sizes[i];
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "bigint_tuning.h";
+
+    BigInt::MulThresholds &t = BigInt::thresholds();
+    t.karatsuba = t.toom3 = t.toom4 = t.ntt = NEVER;
+
+    t.karatsuba = crossover(
+        "karatsuba",
+        [](const BigInt &x, const BigInt &y) { return x.mul_karatsuba(y); }, 8,
+        2048);
+    int lowest = t.karatsuba == NEVER ? 8 : t.karatsuba;
+    t.toom3 = crossover(
+        "toom3",
+        [](const BigInt &x, const BigInt &y) { return x.mul_toom(y, 3); },
+        lowest, 8192);
+    t.toom4 = crossover(
+        "toom4",
+        [](const BigInt &x, const BigInt &y) { return x.mul_toom(y, 4); },
+        t.toom3 == NEVER ? lowest : t.toom3, 8192);
+    t.ntt = crossover(
+        "ntt", [](const BigInt &x, const BigInt &y) { return x.mul_ntt(y); },
+        lowest, 8192);
+
+    // operator* пробует NTT раньше Toom, а Toom-4 раньше Toom-3: ступень с
+    // порогом выше следующей никогда бы не сработала. Такие ступени
+    // закрываем, приравнивая порог к следующему, — bigint.h требует
+    // karatsuba <= toom3 <= toom4 <= ntt.
+    t.toom4 = min(t.toom4, t.ntt);
+    t.toom3 = min(t.toom3, t.toom4);
+    t.karatsuba = min(t.karatsuba, t.toom3);
+
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return 1;
+    }
+    fprintf(out,
+            "// Multiplication crossover points for BigInt, in limbs of the "
+            "shorter\n"
+            "// operand.  Generated by 'make run_tune' (tune.cpp), rerun it on "
+            "the target host.\n");
+    fprintf(out, "const int TUNED_KARATSUBA_THRESHOLD = %d;\n", t.karatsuba);
+    fprintf(out, "const int TUNED_TOOM3_THRESHOLD = %d;\n", t.toom3);
+    fprintf(out, "const int TUNED_TOOM4_THRESHOLD = %d;\n", t.toom4);
+    fprintf(out, "const int TUNED_NTT_THRESHOLD = %d;\n", t.ntt);
+    fclose(out);
+    printf("written %s\n", path);
+    return 0;
+}
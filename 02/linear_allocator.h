@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdlib>
+
+/**
+ * @brief Аллокатор со стратегией линейного выделения памяти
+ *
+ */
+class LinearAllocator {
+  private:
+    size_t m_max_size;
+    char *m_buffer;
+    char *m_position;
+
+  public:
+    /**
+     * @brief Construct a new Linear Allocator object
+     *
+     * @param maxSize
+     *
+     *  Если размер нулевой (отрицательного быть не может),
+     *  не будем брать SIZE_MAX (как в malloc) захватывая всю память, делаем
+     * вырожденный аллокатор, не возвращающий ничего.
+     *
+     */
+    LinearAllocator(size_t maxSize)
+        : m_max_size(0), m_position(nullptr), m_buffer(nullptr) {
+        if (maxSize > 0) m_max_size = maxSize;
+        m_position = m_buffer = (char *)malloc(m_max_size);
+    }
+
+    /**
+     * @brief   Выделение заданной памяти.
+     *          В отличие от malloc отрицательные и нулевые размеры не
+     * поддерживаем, если что не ОК, возвращаем nullptr.
+     *
+     * @param size
+     * @return char*
+     */
+    char *alloc(size_t size) {
+        if (nullptr == m_buffer) return nullptr;
+        if (size == 0) return nullptr;
+        // Вроде так переполнения не поймать, поправьте меня если ---
+        size_t rest_size = m_max_size - (m_position - m_buffer);
+        if (size > rest_size) return nullptr;
+
+        char *result = m_position;
+        m_position += size;
+        return result;
+    }
+
+    /**
+     * @brief Быстрое освобождение всей выделенной пользователям памяти.
+     *
+     */
+    void reset() {
+        m_position = m_buffer;
+    }
+
+    ~LinearAllocator() {
+        if (m_buffer != nullptr) free(m_buffer);
+    };
+};